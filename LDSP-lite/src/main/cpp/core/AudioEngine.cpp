@@ -0,0 +1,159 @@
+#include "AudioEngine.h"
+#include <algorithm> // min
+#include <cstring> // memcpy
+
+namespace ldsplite {
+
+//VIC this is a terrible solution to share internal context with sensors.cpp as extern like in LDSP
+LDSPinternalContext intContext;
+
+AudioEngine::AudioEngine(LDSPlite *ldspLite) {
+  //TODO read some of these from setttings, passed by LDSPlite
+  intContext.audioIn = nullptr;
+  intContext.audioOut = nullptr;
+  intContext.audioFrames = 0;
+  intContext.audioInChannels = 0;
+  intContext.audioOutChannels = 0;
+  intContext.audioSampleRate = 0;
+  intContext.sliders = _parameters.getValues();
+  intContext.sliderCount = _parameters.getCapacity();
+  intContext.ldspLite = ldspLite;
+  intContext.audioPlanar = false;
+  intContext.audioInPlanar = nullptr;
+  intContext.audioOutPlanar = nullptr;
+  intContext.renderBlockLatency = 0;
+  intContext.ctrlEvents = _ctrlEvents.getBlockEvents();
+  intContext.ctrlEventCount = 0;
+  intContext.audioFramesElapsed = 0;
+  intContext.ctrlInputsFloat = false;
+  intContext.audioFramesMax = 0;
+
+  //VIC incapsulate internal pointer
+  userContext = (LDSPcontext*)&intContext;
+
+  _slidersOff = false;
+}
+
+void AudioEngine::setRenderBlockSize(int frames) {
+  _renderBlockSize = (frames > 0) ? frames : 0;
+}
+
+bool AudioEngine::callSetup(int maxFrames) {
+  // planar audio and float control inputs are opt-in, every project has to ask for them again in its own setup()
+  intContext.audioPlanar = false;
+  intContext.ctrlInputsFloat = false;
+
+  // frame clock restarts with the streams, events posted while stopped are stale
+  _callbackFrame = 0;
+  _ctrlEvents.reset();
+  _sensorEvents.reset();
+  intContext.ctrlEventCount = 0;
+  intContext.audioFramesElapsed = 0;
+
+  if(_renderBlockSize > 0) {
+    // the first block played is silence, then output trails input by exactly one block, whatever the callback sizes
+    _blockIn.assign(_renderBlockSize * intContext.audioInChannels, 0);
+    _blockOut.assign(_renderBlockSize * intContext.audioOutChannels, 0);
+    _blockPos = 0;
+    intContext.audioFrames = _renderBlockSize;
+    intContext.renderBlockLatency = _renderBlockSize;
+    maxFrames = _renderBlockSize;
+  }
+  else
+    intContext.renderBlockLatency = 0;
+  intContext.audioFramesMax = maxFrames;
+
+  if(!setup(userContext, nullptr))
+    return false;
+
+  if(intContext.audioPlanar)
+    allocatePlanarBuffers(maxFrames);
+  return true;
+}
+
+void AudioEngine::callCleanup() {
+  cleanup(userContext, nullptr);
+}
+
+//------------------------------------------------------------------------
+
+// callbacks of any size go through the fifo, render() runs whenever a whole block has been collected
+// a callback may end up calling render() zero, one or more times
+void AudioEngine::renderFixedBlocks(int audioFrames, float* audioIn, float* audioOut) {
+  int inChannels = intContext.audioInChannels;
+  int outChannels = intContext.audioOutChannels;
+  // frame clock of the input frames in the block being collected
+  uint64_t blockStartFrame = intContext.audioFramesElapsed - _blockPos;
+
+  int pos = 0;
+  while(pos < audioFrames) {
+    int frames = std::min(audioFrames - pos, _renderBlockSize - _blockPos);
+    memcpy(_blockIn.data() + _blockPos*inChannels, audioIn + pos*inChannels, frames*inChannels*sizeof(float));
+    memcpy(audioOut + pos*outChannels, _blockOut.data() + _blockPos*outChannels, frames*outChannels*sizeof(float));
+    pos += frames;
+    _blockPos += frames;
+
+    // the output block has been played entirely, so it can be overwritten
+    if(_blockPos == _renderBlockSize) {
+      renderBlock(_renderBlockSize, _blockIn.data(), _blockOut.data(), blockStartFrame);
+      blockStartFrame += _renderBlockSize;
+      _blockPos = 0;
+    }
+  }
+}
+
+// no sensor events is the common case, and then the control events are handed over as they are
+void AudioEngine::collectCtrlEvents(uint64_t startFrame, int audioFrames) {
+  int numCtrl = _ctrlEvents.collect(startFrame, audioFrames);
+  int numSensor = _sensorEvents.collect(startFrame, audioFrames);
+  if(numSensor == 0) {
+    intContext.ctrlEvents = _ctrlEvents.getBlockEvents();
+    intContext.ctrlEventCount = numCtrl;
+    return;
+  }
+
+  // both lists are sorted by frame, on ties user events come first
+  const LDSPctrlEvent *ctrl = _ctrlEvents.getBlockEvents();
+  const LDSPctrlEvent *sensor = _sensorEvents.getBlockEvents();
+  int c = 0;
+  int s = 0;
+  int count = 0;
+  while(c < numCtrl || s < numSensor) {
+    if(s == numSensor || (c < numCtrl && ctrl[c].frame <= sensor[s].frame))
+      _mergedEvents[count++] = ctrl[c++];
+    else
+      _mergedEvents[count++] = sensor[s++];
+  }
+  intContext.ctrlEvents = _mergedEvents;
+  intContext.ctrlEventCount = count;
+}
+
+// one contiguous block per direction, channels are laid out back to back
+void AudioEngine::allocatePlanarBuffers(int maxFrames) {
+  // keeps each channel 16-byte aligned relative to the first one, good for 4-wide SIMD
+  int stride = (maxFrames + 3) & ~3;
+
+  _planarIn.assign(stride * intContext.audioInChannels, 0);
+  _planarInChannels.resize(intContext.audioInChannels);
+  for(unsigned int chn=0; chn<intContext.audioInChannels; chn++)
+    _planarInChannels[chn] = _planarIn.data() + chn*stride;
+
+  _planarOut.assign(stride * intContext.audioOutChannels, 0);
+  _planarOutChannels.resize(intContext.audioOutChannels);
+  for(unsigned int chn=0; chn<intContext.audioOutChannels; chn++)
+    _planarOutChannels[chn] = _planarOut.data() + chn*stride;
+
+  intContext.audioInPlanar = _planarInChannels.data();
+  intContext.audioOutPlanar = _planarOutChannels.data();
+}
+
+}  // namespace ldsplite
+
+void LDSP_requestPlanarAudio(LDSPcontext *context) {
+  // context is our internal context in disguise
+  ((ldsplite::LDSPinternalContext *)context)->audioPlanar = true;
+}
+
+void LDSP_requestFloatCtrlInputs(LDSPcontext *context) {
+  ((ldsplite::LDSPinternalContext *)context)->ctrlInputsFloat = true;
+}
@@ -0,0 +1,135 @@
+#include "CtrlEventQueue.h"
+
+namespace ldsplite {
+
+CtrlEventQueue::CtrlEventQueue() {
+  for(uint32_t i=0; i<capacity; i++)
+    _cells[i].seq.store(i, std::memory_order_relaxed);
+}
+
+bool CtrlEventQueue::post(int type, int index, float v0, float v1, float v2, float v3) {
+  return postAt(monotonic_ns(), type, index, v0, v1, v2, v3);
+}
+
+bool CtrlEventQueue::postAt(int64_t timeNs, int type, int index, float v0, float v1, float v2, float v3) {
+  Cell *cell;
+  uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+  for(;;) {
+    cell = &_cells[pos & mask];
+    uint32_t seq = cell->seq.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if(diff == 0) {
+      // free, try to claim it
+      if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if(diff < 0) {
+      // the consumer has not freed this cell yet, queue is full
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+      pos = _enqueuePos.load(std::memory_order_relaxed); // another producer got there first
+  }
+
+  cell->timeNs = timeNs;
+  cell->event.frame = 0;
+  cell->event.type = type;
+  cell->event.index = index;
+  cell->event.values[0] = v0;
+  cell->event.values[1] = v1;
+  cell->event.values[2] = v2;
+  cell->event.values[3] = v3;
+  cell->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void CtrlEventQueue::reset() {
+  int64_t timeNs;
+  LDSPctrlEvent event;
+  while(pop(timeNs, event)) {}
+
+  _nextFrame = 0;
+  _prevCallbackNs = 0;
+  _numPending = 0;
+}
+
+void CtrlEventQueue::beginCallback(int audioFrames) {
+  int64_t callbackNs = monotonic_ns();
+  uint64_t callbackFrame = _nextFrame;
+  _nextFrame += audioFrames;
+
+  double interval = (double)(callbackNs - _prevCallbackNs);
+  bool haveInterval = (_prevCallbackNs > 0) && (interval > 0);
+
+  // if pending is full, the rest waits in the queue for the next callback
+  int64_t timeNs;
+  LDSPctrlEvent event;
+  while(_numPending < capacity && pop(timeNs, event)) {
+    // where the event happened within the previous interval, 0 to 1
+    double position = 0;
+    if(haveInterval) {
+      position = (timeNs - _prevCallbackNs) / interval;
+      if(position < 0)
+        position = 0;
+      else if(position > 1)
+        position = 1; // posted while we are draining
+    }
+    int offset = (int)(position * audioFrames);
+    if(offset >= audioFrames)
+      offset = audioFrames - 1;
+    insertPending(callbackFrame + offset, event);
+  }
+
+  _prevCallbackNs = callbackNs;
+}
+
+int CtrlEventQueue::collect(uint64_t startFrame, int frames) {
+  uint64_t endFrame = startFrame + frames;
+
+  int count = 0;
+  while(count < _numPending && _pending[count].frame < endFrame) {
+    _blockEvents[count] = _pending[count].event;
+    // late events, if any, go at the start of the block
+    _blockEvents[count].frame = (_pending[count].frame > startFrame) ? (uint32_t)(_pending[count].frame - startFrame) : 0;
+    count++;
+  }
+
+  if(count > 0) {
+    for(int i=count; i<_numPending; i++)
+      _pending[i - count] = _pending[i];
+    _numPending -= count;
+  }
+  return count;
+}
+
+//------------------------------------------------------------------------
+
+bool CtrlEventQueue::pop(int64_t &timeNs, LDSPctrlEvent &event) {
+  Cell *cell = &_cells[_dequeuePos & mask];
+  uint32_t seq = cell->seq.load(std::memory_order_acquire);
+  if((int32_t)(seq - (_dequeuePos + 1)) < 0)
+    return false; // empty, or a producer is still writing it
+
+  timeNs = cell->timeNs;
+  event = cell->event;
+  // free for the producer that will come around at this position next lap
+  cell->seq.store(_dequeuePos + capacity, std::memory_order_release);
+  _dequeuePos++;
+  return true;
+}
+
+// events from different threads may be dequeued slightly out of order, so we keep them sorted here
+// from the back, since new events are almost always the latest ones
+void CtrlEventQueue::insertPending(uint64_t frame, const LDSPctrlEvent &event) {
+  int i = _numPending;
+  while(i > 0 && _pending[i - 1].frame > frame) {
+    _pending[i] = _pending[i - 1];
+    i--;
+  }
+  _pending[i].frame = frame;
+  _pending[i].event = event;
+  _numPending++;
+}
+
+}  // namespace ldsplite
@@ -8,7 +8,20 @@
 namespace ldsplite {
 
 LDSPlite::LDSPlite()
-    : _audioEngine{std::make_unique<OboeAudioEngine>(this)} {}
+    : _audioEngine{std::make_unique<OboeAudioEngine>(this)} {
+  _settings.periodSize = 384;
+  _settings.samplerate = 0; // native
+  _settings.captureOff = false;
+  _settings.sensorsOff = true;
+  _settings.parametersOff = false;
+  _settings.verbose = false;
+  _settings.bufferCapacityMult = 2;
+  _settings.performanceMode = perfMode_lowLatency;
+  _settings.renderBlockSize = 0; // follow the callbacks
+  // one sample per block is all render() can see without interpolation
+  for(int i=0; i<LDSP_sensorsMax; i++)
+    _settings.sensorRates[i] = sensorRate_block;
+}
 
 LDSPlite::~LDSPlite() = default;
 
@@ -17,37 +30,108 @@ bool LDSPlite::isStarted() const {
   return _isStarted;
 }
 
+bool LDSPlite::setChannelCounts(int inChannels, int outChannels) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _audioEngine->setChannelCounts(inChannels, outChannels);
+}
+
+void LDSPlite::setAudioSettings(int periodSize, float samplerate, int bufferCapacityMult, int performanceMode) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _settings.periodSize = periodSize;
+  _settings.samplerate = samplerate;
+  _settings.bufferCapacityMult = bufferCapacityMult;
+  _settings.performanceMode = performanceMode;
+}
+
+void LDSPlite::setRenderBlockSize(int frames) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _settings.renderBlockSize = frames;
+}
+
+int LDSPlite::getRenderBlockLatency() {
+  return _audioEngine->getRenderBlockLatency();
+}
+
+void LDSPlite::setLatencyTuning(bool enabled) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _audioEngine->setLatencyTuning(enabled);
+}
+
+int LDSPlite::getLatencyTunerState() {
+  return _audioEngine->getLatencyTunerState();
+}
+
+int LDSPlite::getOutputBufferSize() {
+  // the stream must not be closed in the meantime
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _audioEngine->getOutputBufferSize();
+}
+
+void LDSPlite::setDriftCompensation(bool enabled) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _audioEngine->setDriftCompensation(enabled);
+}
+
+void LDSPlite::getDriftStats(DriftCompensatorStats &stats) {
+  // stats are atomics owned by the engine, no need to lock
+  _audioEngine->getDriftStats(stats);
+}
+
+void LDSPlite::setSensorRate(int sensor, float rate) {
+  if(sensor < 0 || sensor >= LDSP_sensor::count) {
+    LDSP_log("Sensor %d out of range, max is %d", sensor, LDSP_sensor::count - 1);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _settings.sensorRates[sensor] = rate;
+}
+
+int LDSPlite::getSensorRates(float *rates, int count) {
+  // the sensors must not be cleaned up in the meantime
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!_isStarted)
+    return 0;
+  return ::getSensorRates(rates, count);
+}
+
 //VIC start and stop with sensors works only once! check it out@
 void LDSPlite::start() {
   LDSP_log("start() called");
   std::lock_guard<std::mutex> lock(_mutex);
 
-  _audioEngine->init();
+  // init() overwrites the copy with the values granted by the device
+  LDSPinitSettings settings = _settings;
+  if(_audioEngine->init(&settings) != oboe::Result::OK) {
+    LDSP_log("Could not open audio streams.");
+    return;
+  }
+  LDSP_log("period size %d, samplerate %.0f, buffer capacity %d periods, performance mode %d",
+           settings.periodSize, settings.samplerate, settings.bufferCapacityMult, settings.performanceMode);
 
   //TODO move this stuff to GUI
-  // and pass some of this stuff to audioEngine
-  LDSPinitSettings settings;
-  settings.samplerate = _audioEngine->getSampleRate();
-  settings.periodSize = _audioEngine->getFramesPerCallback();
   settings.captureOff = !_audioEngine->getFullDuplex();
 
-  settings.sensorsOff = true;
-  settings.parametersOff = false;
-
-  settings.verbose = false;
-
+  // sensor samples also reach render() as control events, at the frame where they were sampled
+  setSensorEventCallback([this](int64_t timeNs, const sensor_sample &sample) {
+    _audioEngine->postSensorEvent(timeNs, sample.sensorIndex, sample.data[0], sample.data[1], sample.data[2], sample.data[3]);
+  });
   LDSP_initSensors(&settings);
 
   _ctrlInputs.setupContext(&ldsplite::intContext);
   // we use a callback to update the ctrlInput buffer in OboeAudioEngine,
   // so that the Ctrlnputs class is transparent to the OboeAudioEngine class
+  // sensors ride along, samples queued by the sensor thread are applied to the sensor buffer
   _audioEngine->setUpdateCtrlInBufferCallback([this]() {
     _ctrlInputs.updateBuffer();
+    updateSensors();
   });
 
   const auto result = _audioEngine->start();
   if (result == oboe::Result::OK) {
     _isStarted = true;
+    if(_audioEngine->getRenderBlockLatency() > 0)
+      LDSP_log("render block size %d, adds %d frames [%.2f ms] of latency", settings.renderBlockSize,
+               _audioEngine->getRenderBlockLatency(), 1000.0f * _audioEngine->getRenderBlockLatency() / settings.samplerate);
   } else {
     LDSP_log("Could not start playback.");
   }
@@ -63,6 +147,7 @@ void LDSPlite::stop() {
 
 void LDSPlite::updateAnyTouch(int state) {
   _ctrlInputs.updateAnyTouch(state);
+  _audioEngine->postCtrlEvent(ctrlEvt_anyTouch, 0, state);
 }
 
 void LDSPlite::updateTouch(int slot, int id, float x, float y, float pressure,
@@ -71,35 +156,68 @@ void LDSPlite::updateTouch(int slot, int id, float x, float y, float pressure,
   _ctrlInputs.updateTouch(slot, id, x, y, pressure,
                           majAxis, minAxis, orientation,
                           majWidth, minWidth);
+  _audioEngine->postCtrlEvent(ctrlEvt_touch, slot, x, y, pressure, id);
+}
+
+void LDSPlite::updateTouchBatch(const float* records, int count, int anyTouch) {
+  _ctrlInputs.updateTouchBatch(records, count, anyTouch);
+
+  // same events as the unbatched calls, so that render() cannot tell the difference
+  if(anyTouch != TouchHandler::ANY_TOUCH_UNCHANGED)
+    _audioEngine->postCtrlEvent(ctrlEvt_anyTouch, 0, anyTouch);
+  for(int r=0; r<count; r++) {
+    const float* record = records + r*TouchHandler::BATCH_RECORD_SIZE;
+    int slot = (int)record[0];
+    if(record[1] == -1)
+      _audioEngine->postCtrlEvent(ctrlEvt_touchEnd, slot, 0);
+    else
+      _audioEngine->postCtrlEvent(ctrlEvt_touch, slot, record[2], record[3], record[4], record[1]);
+  }
 }
 
 void LDSPlite::updateHover(int slot, float hoverX, float hoverY) {
   _ctrlInputs.updateHover(slot, hoverX, hoverY);
+  _audioEngine->postCtrlEvent(ctrlEvt_hover, slot, hoverX, hoverY);
 }
 
 void LDSPlite::clearTouch(int slot) {
   _ctrlInputs.clearTouch(slot);
+  _audioEngine->postCtrlEvent(ctrlEvt_touchEnd, slot, 0);
 }
 
 void LDSPlite::setScreenResolution(float width, float height) {
   _ctrlInputs.setScreenResolution(width, height);
 }
 
+void LDSPlite::updateButton(int channel, bool pressed) {
+  // key repeats do not make it into events
+  if(_ctrlInputs.updateButton(channel, pressed))
+    _audioEngine->postCtrlEvent(ctrlEvt_button, channel, pressed ? 1 : 0);
+}
+
 
-void LDSPlite::setSlider0(float value) {
-  _audioEngine->setSlider0(value);
+void LDSPlite::setParameter(int index, float value) {
+  if(!_audioEngine->setParameter(index, value))
+    LDSP_log("Parameter %d out of range, max is %d", index, AudioEngine::maxSliders - 1);
 }
 
-void LDSPlite::setSlider1(float value) {
-  _audioEngine->setSlider1(value);
+void LDSPlite::setParameterSmoothing(int index, float rampMs) {
+  if(!_audioEngine->setParameterSmoothing(index, rampMs))
+    LDSP_log("Parameter %d out of range, max is %d", index, AudioEngine::maxSliders - 1);
 }
 
-void LDSPlite::setSlider2(float value) {
-  _audioEngine->setSlider2(value);
+void LDSPlite::setRenderTimingEnabled(bool enabled) {
+  _audioEngine->setRenderTimingEnabled(enabled);
 }
 
-void LDSPlite::setSlider3(float value){
-  _audioEngine->setSlider3(value);
+void LDSPlite::resetRenderTiming() {
+  _audioEngine->resetRenderTiming();
+}
+
+void LDSPlite::getRenderTimingStats(RenderTimingStats &stats) {
+  // xrun count is read from the streams, which must not be closed in the meantime
+  std::lock_guard<std::mutex> lock(_mutex);
+  _audioEngine->getRenderTimingStats(stats);
 }
 
 
@@ -1,6 +1,8 @@
 #include "OboeAudioEngine.h"
 
 #include <utility>
+#include <unistd.h> // usleep
+#include <algorithm> // max
 #include "LDSP_log.h"
 
 // defined in root's CMakeLists.txt
@@ -19,30 +21,8 @@ namespace ldsplite {
 static std::atomic<int> instances{0};
 #endif
 
-//VIC this is a terrible solution to share internal context with sensors.cpp as extern like in LDSP
-LDSPinternalContext intContext;
-
-OboeAudioEngine::OboeAudioEngine(LDSPlite *ldspLite) {
-  _slider0.store(0);
-  _slider1.store(0);
-  _slider2.store(0);
-  _slider3.store(0);
-
-  //TODO read some of these from setttings, passed by LDSPlite
-  intContext.audioIn = nullptr;
-  intContext.audioOut = nullptr;
-  intContext.audioFrames = 0;
-  intContext.audioInChannels = 0;
-  intContext.audioOutChannels = 0;
-  intContext.audioSampleRate = 0;
-  intContext.sliders = _sliders;
-  intContext.ldspLite = ldspLite;
-
-  //VIC incapsulate internal pointer
-  userContext = (LDSPcontext*)&intContext;
-
+OboeAudioEngine::OboeAudioEngine(LDSPlite *ldspLite) : AudioEngine(ldspLite) {
   _fullDuplex = true;
-  _slidersOff = false;
 
   setMNumInputBurstsCushion(0);
 }
@@ -51,43 +31,125 @@ OboeAudioEngine::~OboeAudioEngine() {
   OboeAudioEngine::stop();
 }
 
-void OboeAudioEngine::init() {
+bool OboeAudioEngine::setChannelCounts(int inChannels, int outChannels) {
+  if(inChannels < 1 || inChannels > maxChannelCount || outChannels < 1 || outChannels > maxChannelCount) {
+    LDSP_log("Invalid channel counts %d in, %d out (allowed 1 to %d), keeping %d in, %d out",
+             inChannels, outChannels, maxChannelCount, _inChannels, _outChannels);
+    return false;
+  }
+  _inChannels = inChannels;
+  _outChannels = outChannels;
+  return true;
+}
+
+Result OboeAudioEngine::init(LDSPinitSettings *settings) {
   LDSP_log("OboeAudioEngine::init()");
   bool isInput;
 
+  // requested values, invalid ones leave the defaults in place
+  if(settings->periodSize > 0)
+    _bufferSize = settings->periodSize;
+  if(settings->samplerate >= 0)
+    _sampleRate = (int) settings->samplerate; // 0 means native samplerate
+  if(settings->bufferCapacityMult > 0)
+    _bufferCapacityMult = settings->bufferCapacityMult;
+  switch(settings->performanceMode) {
+    case perfMode_none: _performanceMode = PerformanceMode::None; break;
+    case perfMode_powerSaving: _performanceMode = PerformanceMode::PowerSaving; break;
+    default: _performanceMode = PerformanceMode::LowLatency; break;
+  }
+  // applied at callSetup(), independent from the streams
+  setRenderBlockSize(settings->renderBlockSize);
+
   isInput = false;
-  createStream(isInput);
+  Result result = createStream(isInput);
+  if(result != Result::OK)
+    return result;
+
+  // the device moves audio in bursts, callbacks that are not a multiple of the burst size are split/merged and jitter
+  // we can only know the burst size once the stream is open, so if the request is not aligned we re-open the stream
+  int burstSize = getOutputStream()->getFramesPerBurst();
+  int alignedBufferSize = alignToBurst(_bufferSize, burstSize);
+  if(alignedBufferSize != _bufferSize) {
+    LDSP_log("Period size %d is not a multiple of burst size %d, using %d instead", _bufferSize, burstSize, alignedBufferSize);
+    int requestedBufferSize = _bufferSize;
+    _bufferSize = alignedBufferSize;
+    _outStream->close();
+    result = createStream(isInput);
+    if(result != Result::OK) {
+      // the aligned stream was refused, go back to the period size that already opened once
+      LDSP_log("Could not re-open output stream with period size %d, falling back to %d", alignedBufferSize, requestedBufferSize);
+      _bufferSize = requestedBufferSize;
+      result = createStream(isInput);
+    }
+    if(result != Result::OK) {
+      // never leave the closed stream behind, stop() and the stats would use it
+      setOutputStream(nullptr);
+      _outStream = nullptr;
+      return result;
+    }
+  }
 
   if(_fullDuplex) {
     isInput = true;
-    createStream(isInput);
+    result = createStream(isInput);
+    if(result != Result::OK)
+      return result;
   }
 
   //VIC
   intContext.projectName = PRJ_NAME;
   intContext.audioSampleRate = (float) getOutputStream()->getSampleRate();
-  intContext.audioInChannels = channelCount;
-  intContext.audioOutChannels = channelCount;
+  // channel conversion is allowed, so we should get what we asked for, but better to trust the streams
+  // counts are fixed for the lifetime of the streams, so render() and audioRead()/audioWrite() need no per-sample checks
+  intContext.audioOutChannels = getOutputStream()->getChannelCount();
+  if(_fullDuplex)
+    intContext.audioInChannels = getInputStream()->getChannelCount();
+  else
+    intContext.audioInChannels = _inChannels; // silent input, but still as many channels as requested
   intContext.audioFrames = getOutputStream()->getFramesPerCallback();
+
+  // what we actually got
+  settings->periodSize = intContext.audioFrames;
+  settings->samplerate = intContext.audioSampleRate;
+  settings->bufferCapacityMult = getOutputStream()->getBufferCapacityInFrames() / intContext.audioFrames;
+  switch(getOutputStream()->getPerformanceMode()) {
+    case PerformanceMode::None: settings->performanceMode = perfMode_none; break;
+    case PerformanceMode::PowerSaving: settings->performanceMode = perfMode_powerSaving; break;
+    default: settings->performanceMode = perfMode_lowLatency; break;
+  }
+
+  return Result::OK;
 }
 
 Result OboeAudioEngine::start() {
-  setup(userContext, nullptr);
+  // callbacks can never be bigger than the buffer capacity
+  callSetup(getOutputStream()->getBufferCapacityInFrames());
 
+  oboe::Result result;
   if(_fullDuplex)
-    return FullDuplexStream::start();
+    result = FullDuplexStream::start();
   else {
-    silentInBuff = new float[getOutputStream()->getFramesPerCallback()];
-    memset(silentInBuff, 0, sizeof(float)*getOutputStream()->getFramesPerCallback());
+    int silentInSamples = getOutputStream()->getFramesPerCallback() * intContext.audioInChannels;
+    silentInBuff = new float[silentInSamples];
+    memset(silentInBuff, 0, sizeof(float)*silentInSamples);
 
-    oboe::Result result = getOutputStream()->requestStart();
+    result = getOutputStream()->requestStart();
     if (result != oboe::Result::OK) {
-      delete silentInBuff;
+      delete[] silentInBuff;
+      silentInBuff = nullptr;
       return result;
     }
+  }
 
-    return result;
+  if(result == oboe::Result::OK && _latencyTuning) {
+    _tunerShouldStop = false;
+    _tunerState = tuner_tuning;
+    _tunerRunning = true;
+    pthread_create(&tuner_thread, NULL, tuner_func_static, this);
   }
+
+  return result;
 }
 
 
@@ -97,6 +159,9 @@ Result OboeAudioEngine::stop() {
   Result result_out = Result::OK;
   Result result_in = Result::OK;
 
+  // the tuner touches the output stream, so it goes first
+  stopLatencyTuner();
+
   if(_outStream != nullptr) {
     result_out = _outStream->requestStop();
     _outStream->close();
@@ -114,8 +179,10 @@ Result OboeAudioEngine::stop() {
 //  else if (_outStream != nullptr)
 //    cleanup(userContext, nullptr);
 
-  if(silentInBuff != nullptr)
-    delete silentInBuff;
+  if(silentInBuff != nullptr) {
+    delete[] silentInBuff;
+    silentInBuff = nullptr;
+  }
 
   if(result_out != Result::OK)
     return result_out;
@@ -124,7 +191,7 @@ Result OboeAudioEngine::stop() {
       return result_in;
   }
 
-  cleanup(userContext, nullptr);
+  callCleanup();
 
   return Result::OK;
 }
@@ -151,22 +218,138 @@ DataCallbackResult OboeAudioEngine::onBothStreamsReady(float *inputData,
                                                        int   numOutputFrames) {
 
   //LDSP_log("in frames: %d, out frames: %d\n", numInputFrames, numOutputFrames);
+  // without drift compensation the input may be short, render() always sees a full period [input buffers are sized on the output capacity]
+  if(numInputFrames < numOutputFrames)
+    memset(inputData + numInputFrames*intContext.audioInChannels, 0, sizeof(float)*(numOutputFrames-numInputFrames)*intContext.audioInChannels);
   callRender(numOutputFrames, inputData, outputData);
 
   return DataCallbackResult::Continue;
 };
 
+// underruns on the output plus overruns on the input
+// xrun count is only supported on AAudio, with OpenSL ES we return -1 like when the streams are not open
+int OboeAudioEngine::getXRunCount() {
+  if(_outStream == nullptr)
+    return -1;
+
+  auto outXruns = _outStream->getXRunCount();
+  if(!outXruns)
+    return -1;
+  int xruns = outXruns.value();
+
+  if(_fullDuplex && _inStream != nullptr) {
+    auto inXruns = _inStream->getXRunCount();
+    if(inXruns)
+      xruns += inXruns.value();
+  }
+  return xruns;
+}
+
+
+void OboeAudioEngine::setLatencyTuning(bool enabled) {
+  _latencyTuning = enabled;
+  if(!enabled)
+    _tunerState = tuner_off;
+}
+
+int OboeAudioEngine::getLatencyTunerState() {
+  return _tunerState;
+}
+
+int OboeAudioEngine::getOutputBufferSize() {
+  if(_outStream == nullptr)
+    return -1;
+  return _outStream->getBufferSizeInFrames();
+}
+
 
 //------------------------------------------------------------------------
 
+void OboeAudioEngine::stopLatencyTuner() {
+  if(!_tunerRunning)
+    return;
+
+  _tunerShouldStop = true;
+  pthread_join(tuner_thread, NULL);
+  _tunerRunning = false;
+  if(_tunerState == tuner_tuning)
+    _tunerState = tuner_off;
+}
+
+// sleeps in small chunks, to stop promptly; returns false if asked to stop
+static bool tunerSleep(std::atomic<bool> &shouldStop, int ms) {
+  for(int t=0; t<ms && !shouldStop; t+=100)
+    usleep(100000);
+  return !shouldStop;
+}
+
+void* OboeAudioEngine::tuner_func() {
+  // time each buffer size is given to produce underruns before going further down
+  constexpr int settleMs = 500;
+  constexpr int stepMs = 2000;
+
+  std::shared_ptr<oboe::AudioStream> stream = _outStream;
+
+  if(!stream->getXRunCount()) {
+    LDSP_log("Latency tuner not supported by audio API, buffer size stays at %d frames", stream->getBufferSizeInFrames());
+    _tunerState = tuner_unsupported;
+    return (void *)0;
+  }
+
+  int burstSize = stream->getFramesPerBurst();
+  // below one callback the stream would starve for sure
+  int minBufferSize = std::max(burstSize, stream->getFramesPerCallback());
+
+  // safe start, the whole capacity
+  stream->setBufferSizeInFrames(stream->getBufferCapacityInFrames());
+  int bufferSize = stream->getBufferSizeInFrames();
+  LDSP_log("Latency tuner starting from buffer size %d frames, burst size %d", bufferSize, burstSize);
+
+  if(!tunerSleep(_tunerShouldStop, settleMs))
+    return (void *)0;
+  int xruns = stream->getXRunCount().value();
+
+  while(bufferSize - burstSize >= minBufferSize) {
+    auto result = stream->setBufferSizeInFrames(bufferSize - burstSize);
+    if(!result)
+      break;
+    int newBufferSize = result.value();
+    if(newBufferSize >= bufferSize)
+      break; // device won't go any lower
+
+    if(!tunerSleep(_tunerShouldStop, stepMs))
+      return (void *)0;
+
+    int newXruns = stream->getXRunCount().value();
+    if(newXruns != xruns) {
+      // too far, back off one step
+      stream->setBufferSizeInFrames(bufferSize);
+      LDSP_log("Latency tuner: underruns at buffer size %d frames, backing off", newBufferSize);
+      break;
+    }
+    bufferSize = newBufferSize;
+  }
+
+  bufferSize = stream->getBufferSizeInFrames();
+  LDSP_log("Latency tuner settled on buffer size %d frames [%.2f ms]", bufferSize, 1000.0f * bufferSize / stream->getSampleRate());
+  _tunerState = tuner_done;
+  return (void *)0;
+}
+
+void* OboeAudioEngine::tuner_func_static(void* arg) {
+  OboeAudioEngine* engine = static_cast<OboeAudioEngine*>(arg);
+  return engine->tuner_func();
+}
+
+
 Result OboeAudioEngine::createStream(bool isInput) {
   LDSP_log("OboeAudioEngine::createStream()");
   AudioStreamBuilder builder;
-  builder.setPerformanceMode(PerformanceMode::LowLatency)
+  builder.setPerformanceMode(_performanceMode)
       ->setDirection(isInput ? Direction::Input : Direction::Output)
       ->setSharingMode(SharingMode::Exclusive)
       ->setFormat(AudioFormat::Float)
-      ->setChannelCount(channelCount)
+      ->setChannelCount(isInput ? _inChannels : _outChannels)
       ->setSampleRateConversionQuality(SampleRateConversionQuality::Best)
       ->setUsage(Usage::Media)
       ->setContentType(ContentType::Music)
@@ -180,7 +363,7 @@ Result OboeAudioEngine::createStream(bool isInput) {
     builder.setSampleRate(_sampleRate); // otherwise, native samplerate is set automatically
 
   if(!isInput) {
-    builder.setBufferCapacityInFrames(2 * _bufferSize);
+    builder.setBufferCapacityInFrames(_bufferCapacityMult * _bufferSize);
     builder.setFramesPerCallback(_bufferSize); // app buffer size
     builder.setDataCallback(this);
   }
@@ -197,6 +380,10 @@ Result OboeAudioEngine::createStream(bool isInput) {
 
   std::shared_ptr<oboe::AudioStream> oboeStream;
   Result result = builder.openStream(oboeStream);
+  if(result != Result::OK) {
+    LDSP_log("Could not open %s stream: %s", isInput ? "input" : "output", convertToText(result));
+    return result;
+  }
 
   if(!isInput) {
     oboeStream->setBufferSizeInFrames(_bufferSize);
@@ -229,13 +416,8 @@ Result OboeAudioEngine::createStream(bool isInput) {
   // _OpenSLES -> cannot set it, it is automatically set as 2*burstSize for output and a bigger number that does not make much sense for input
   //              but this is only visible via dumpsys media.audio_flinger, cos the values we log here seem to be bogus
   // burst size seems to be easy to read and should represent audio HAL buffer ; on Motorola g7 [Aaudio], input and output burst size is different!!! input is bigger
-  //TODO maybe it'd be cool in Aaudio is the passed buffer size is a multiple of output burst size and suggest that if it's not
-  // but more tests are needed to check if extending this test to audio input makes sense—so far, for it seems that in buffer size cannot be modified...
 
 
-  if(result != Result::OK)
-    return result;
-
   // pass raw pointer to inner object AND pass ownership of local shared
   // pointer to member shared pointer
   if(!isInput) {
@@ -250,6 +432,15 @@ Result OboeAudioEngine::createStream(bool isInput) {
   return result;
 }
 
+// closest multiple of the burst size, never less than one burst
+int OboeAudioEngine::alignToBurst(int frames, int burstSize) {
+  if(burstSize <= 0)
+    return frames;
 
+  int bursts = (frames + burstSize/2) / burstSize;
+  if(bursts < 1)
+    bursts = 1;
+  return bursts * burstSize;
+}
 
-}  // namespace ldsplite
\ No newline at end of file
+}  // namespace ldsplite
@@ -0,0 +1,110 @@
+#include "ParameterBus.h"
+
+namespace ldsplite {
+
+ParameterBus::ParameterBus(int capacity) {
+  _capacity = (capacity > 0) ? capacity : 1;
+  _words = (_capacity + bitsPerWord - 1) / bitsPerWord;
+
+  _targets = std::make_unique<std::atomic<float>[]>(_capacity);
+  _rampMs = std::make_unique<std::atomic<float>[]>(_capacity);
+  _dirty = std::make_unique<std::atomic<uint64_t>[]>(_words);
+  _values = std::make_unique<float[]>(_capacity);
+  _rampTargets = std::make_unique<float[]>(_capacity);
+  _rampSteps = std::make_unique<float[]>(_capacity);
+  _rampFramesLeft = std::make_unique<int[]>(_capacity);
+  _ramping = std::make_unique<int[]>(_capacity);
+  _rampSlot = std::make_unique<int[]>(_capacity);
+
+  for(int i=0; i<_capacity; i++) {
+    _targets[i].store(0, std::memory_order_relaxed);
+    _rampMs[i].store(0, std::memory_order_relaxed);
+    _values[i] = 0;
+    _rampFramesLeft[i] = 0;
+    _rampSlot[i] = -1;
+  }
+  for(int w=0; w<_words; w++)
+    _dirty[w].store(0, std::memory_order_relaxed);
+}
+
+bool ParameterBus::set(int index, float value) {
+  if(index < 0 || index >= _capacity)
+    return false;
+
+  _targets[index].store(value, std::memory_order_relaxed);
+  // release, so that the audio thread sees the new target once it sees the flag
+  _dirty[index / bitsPerWord].fetch_or(uint64_t(1) << (index % bitsPerWord), std::memory_order_release);
+  return true;
+}
+
+bool ParameterBus::setSmoothing(int index, float rampMs) {
+  if(index < 0 || index >= _capacity)
+    return false;
+
+  _rampMs[index].store((rampMs > 0) ? rampMs : 0, std::memory_order_relaxed);
+  return true;
+}
+
+void ParameterBus::update(int audioFrames, float sampleRate) {
+  for(int w=0; w<_words; w++) {
+    // cheap check first, most of the times nothing changed
+    if(_dirty[w].load(std::memory_order_relaxed) == 0)
+      continue;
+
+    uint64_t bits = _dirty[w].exchange(0, std::memory_order_acquire);
+    while(bits) {
+      int index = w*bitsPerWord + __builtin_ctzll(bits);
+      bits &= bits - 1; // clears lowest bit
+      startRamp(index, _targets[index].load(std::memory_order_relaxed), sampleRate);
+    }
+  }
+
+  // new ramps included, so that render() already sees them move in this block
+  for(int r=0; r<_numRamping;) {
+    int index = _ramping[r];
+    if(_rampFramesLeft[index] > audioFrames) {
+      _values[index] += _rampSteps[index] * audioFrames;
+      _rampFramesLeft[index] -= audioFrames;
+      r++;
+    }
+    else {
+      // done, land exactly on the target; the last ramping index is swapped in here, so r stays
+      _values[index] = _rampTargets[index];
+      stopRamp(index);
+    }
+  }
+}
+
+//------------------------------------------------------------------------
+
+void ParameterBus::startRamp(int index, float target, float sampleRate) {
+  int frames = (int)(_rampMs[index].load(std::memory_order_relaxed) * 0.001f * sampleRate);
+  if(frames <= 0) {
+    _values[index] = target;
+    stopRamp(index);
+    return;
+  }
+
+  // if already ramping, we just retarget from where it is now
+  if(_rampSlot[index] < 0) {
+    _rampSlot[index] = _numRamping;
+    _ramping[_numRamping++] = index;
+  }
+  _rampTargets[index] = target;
+  _rampSteps[index] = (target - _values[index]) / frames;
+  _rampFramesLeft[index] = frames;
+}
+
+void ParameterBus::stopRamp(int index) {
+  int slot = _rampSlot[index];
+  if(slot < 0)
+    return;
+
+  int last = _ramping[--_numRamping];
+  _ramping[slot] = last;
+  _rampSlot[last] = slot;
+  _rampSlot[index] = -1;
+  _rampFramesLeft[index] = 0;
+}
+
+}  // namespace ldsplite
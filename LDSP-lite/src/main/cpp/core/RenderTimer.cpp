@@ -0,0 +1,42 @@
+#include "RenderTimer.h"
+
+namespace ldsplite {
+
+RenderTimer::RenderTimer() {
+  clear();
+}
+
+void RenderTimer::setEnabled(bool enabled) {
+  _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void RenderTimer::getStats(RenderTimingStats &stats) const {
+  stats.callbacks = _callbacks.load(std::memory_order_relaxed);
+  stats.meanLoad = (stats.callbacks > 0) ? (float)(_totalLoad.load(std::memory_order_relaxed) / stats.callbacks) : 0;
+  stats.worstLoad = _worstLoad.load(std::memory_order_relaxed);
+  stats.overruns = _overruns.load(std::memory_order_relaxed);
+  stats.xruns = -1; // filled in by the audio engine
+  for(int i=0; i<RenderTimingStats::histogramBins; i++)
+    stats.histogram[i] = _histogram[i].load(std::memory_order_relaxed);
+}
+
+void RenderTimer::reset() {
+  // if timing is off the audio thread is not recording, so we can clear right away
+  if(!isEnabled())
+    clear();
+  else
+    _resetRequested.store(true, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------
+
+void RenderTimer::clear() {
+  _callbacks.store(0, std::memory_order_relaxed);
+  _totalLoad.store(0, std::memory_order_relaxed);
+  _worstLoad.store(0, std::memory_order_relaxed);
+  _overruns.store(0, std::memory_order_relaxed);
+  for(int i=0; i<RenderTimingStats::histogramBins; i++)
+    _histogram[i].store(0, std::memory_order_relaxed);
+}
+
+}  // namespace ldsplite
@@ -24,16 +24,22 @@ The Bela software is distributed under the GNU Lesser General Public License (LG
 #include <seasocks/Server.h>
 #include <seasocks/WebSocket.h>
 #include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <sys/eventfd.h>
 
 
-constexpr unsigned int WSServerClientSleepUs = 100;
-
-WSServer::WSServer(){}
+WSServer::WSServer(){
+	initClient();
+}
 WSServer::WSServer(unsigned int port){
+	initClient();
 	setup(port);
 }
 WSServer::~WSServer(){
   cleanup();
+  if(clientWakeFd != -1)
+	::close(clientWakeFd);
 }
 
 struct GuiWSHandler : seasocks::WebSocket::Handler {
@@ -63,15 +69,18 @@ struct GuiWSHandler : seasocks::WebSocket::Handler {
 };
 
 
+// what the client thread needs, before any thread is started
+void WSServer::initClient() {
+	clientWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	for(unsigned int i = 0; i < batch_count; i++)
+		freeBatches.push(&batches[i]);
+}
+
 void WSServer::setup(unsigned int port) {
 	_port = port;
 	auto logger = std::make_shared<seasocks::IgnoringLogger>();
 	server = std::make_shared<seasocks::Server>(logger);
 
-    // prepare client loop vars
-    outputs_writePtr.store(-1);
-	outputs_readPtr = -1;
-
 	shouldStop = false;
 	pthread_create(&client_thread, NULL, client_func_static, this);
 	pthread_create(&serve_thread, NULL, serve_func_static, this);
@@ -97,34 +106,122 @@ int WSServer::send(const char* address, const char* str) {
 
 int WSServer::send(const char* address, const void* buf, unsigned int size) 
 {
-	// ensure the size does not exceed the buffer capacity
-    if (size > WSOutDataMax) {
-        size = WSOutDataMax; // truncate data
-		printf("Web socket server warning! The data buffer sent to %s is too long and will be truncated!\n", address);
-    }
+	return send(address, nullptr, buf, size);
+}
+
+int WSServer::send(const char* address, const char* header, const void* buf, unsigned int size)
+{
+	unsigned int headerSize = (header != nullptr) ? strlen(header) : 0;
+	if (headerSize > WSOutDataMax)
+		return -1;
+
+	// long messages go through a slab
+	if (size > WSOutDataMax) {
+		// ensure the size does not exceed the slab capacity
+		if (size > WSSlabSize) {
+			size = WSSlabSize; // truncate data
+			truncatedCount.fetch_add(1, std::memory_order_relaxed); // the client thread prints the warning
+		}
+		void* slab = acquireSlab();
+		if(slab == nullptr)
+			return -1; // all in flight, the server is not keeping up
+		memcpy(slab, buf, size);
+		return queueSlab(address, header, headerSize, slab, size);
+	}
+
+	// pack up arguments, straight into the queue
+	void* record = outputs.beginWrite(sizeof(WSOutputData) + headerSize + size);
+	if(record == nullptr)
+		return -1; // full, the client thread is not keeping up
+
+	WSOutputData* out = (WSOutputData*)record;
+	out->address = address;
+	out->slabSize = 0;
+	out->headerSize = headerSize;
+	memcpy(out + 1, header, headerSize);
+	memcpy((char*)(out + 1) + headerSize, buf, size);
+	outputs.commitWrite(record); // now the client thread can see it
+
+	// the fence pairs with the one in client_func(): either the client sees this message while draining, or we see it is not pending and wake it up
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(!clientWakePending.load(std::memory_order_relaxed) && !clientWakePending.exchange(true, std::memory_order_relaxed))
+		wakeClient();
+
+	return 0;
+}
+
+void* WSServer::acquireSlab()
+{
+	unsigned int first = slabNext.load(std::memory_order_relaxed);
+	for(unsigned int i = 0; i < WSSlabCount; i++) {
+		unsigned int index = (first + i) % WSSlabCount;
+		// CAS, since several threads may send at the same time
+		// acquire, so that whoever released the slab is done with the memory
+		bool inUse = false;
+		if(!slabInUse[index].load(std::memory_order_relaxed) &&
+		   slabInUse[index].compare_exchange_strong(inUse, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+			slabNext.store((index + 1) % WSSlabCount, std::memory_order_relaxed);
+			return getSlab(index);
+		}
+	}
+	return nullptr;
+}
 
+int WSServer::sendSlab(const char* address, void* slab, unsigned int size)
+{
+	return queueSlab(address, nullptr, 0, slab, size);
+}
 
-	// pack up arguments	
-	WSOutputData out;
-	out.address = (char *)address;
-	memcpy(out.buff, buf, size);    // Copy the data into the buffer; no need to erase it, because we store size too!
-	out.size = size;
+int WSServer::queueSlab(const char* address, const char* header, unsigned int headerSize, void* slab, unsigned int size)
+{
+	unsigned int index = ((char*)slab - slabs.get()) / (WSSlabSize+1);
+	if (size > WSSlabSize) {
+		size = WSSlabSize; // truncate data
+		truncatedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	((char*)slab)[size] = '\0'; // for text messages, that are sent in place as C strings
 
-	// read the index of the last value we wrote
-	int writePtr = outputs_writePtr.load();
-	writePtr = (writePtr + 1) % output_queue_size;
+	// only a reference goes in the queue, along with the header
+	void* record = outputs.beginWrite(sizeof(WSOutputData) + headerSize, index + 1);
+	if(record == nullptr) {
+		releaseSlab(slab);
+		return -1; // full, the client thread is not keeping up
+	}
 
-	//printf("---------------> buffer %d[%d]: %s\n", writePtr, size, (char *)out.buff);
+	WSOutputData* out = (WSOutputData*)record;
+	out->address = address;
+	out->slabSize = size;
+	out->headerSize = headerSize;
+	memcpy(out + 1, header, headerSize);
+	outputs.commitWrite(record);
 
-	outputs[writePtr].store(out); // push output into queue
-	outputs_writePtr.store(writePtr);  // update index of the last value in queue
+	std::atomic_thread_fence(std::memory_order_seq_cst); // see send()
+	if(!clientWakePending.load(std::memory_order_relaxed) && !clientWakePending.exchange(true, std::memory_order_relaxed))
+		wakeClient();
 
 	return 0;
 }
 
+// any thread that owns the slab
+void WSServer::releaseSlab(void* slab)
+{
+	unsigned int index = ((char*)slab - slabs.get()) / (WSSlabSize+1);
+	slabInUse[index].store(false, std::memory_order_release);
+}
+
+// a non-blocking write, the only syscall send() may make
+void WSServer::wakeClient()
+{
+	uint64_t one = 1;
+	// can only fail if the counter is full [the client is awake anyway] or there is no eventfd
+	ssize_t ret = ::write(clientWakeFd, &one, sizeof(one));
+	(void)ret;
+}
+
 void WSServer::cleanup()
 {
 	shouldStop = true;
+	wakeClient();
 	server->terminate();
 	// wait for completion
 	pthread_join(client_thread, NULL);
@@ -157,58 +254,171 @@ void* WSServer::client_func()
 {
 	while(!shouldStop)
 	{
-		// here we use a non-blocking circular buffer to make sure that all output values are sent
-        // this is guaranteed by the large size of the buffer, i.e., the store index [write pointer] will never overtake by a lap the load index [read pointer]
-
-        // read the index of the latest value that was written
-        int writePtr = outputs_writePtr.load();
-
-        // until the index of the last written value is equal to the index of the last value we read/sent...
-        while(outputs_readPtr != writePtr) 
-        { 
-			outputs_readPtr = (outputs_readPtr + 1) % output_queue_size;  // move the read pointer forward, it will be the latest value we send
-
-			WSOutputData output = outputs[outputs_readPtr].load(); // get current output
-			// unpack 
-			std::shared_ptr<GuiWSHandler> handler = address_book.at(output.address);
-			const void* buf = output.buff;
-			unsigned int size = output.size;
-
-			//printf("---------------> %s --- buffer %d[%d]: %s\n", output.address, outputs_readPtr, size, (char *)output.buff);
-			 
-			try  
+		// sleep until send() or cleanup() wake us up
+		struct pollfd pfd = {clientWakeFd, POLLIN, 0};
+		// without an eventfd [should never happen] poll() ignores the fd and we fall back to polling the queue every ms
+		if(::poll(&pfd, 1, (clientWakeFd != -1) ? -1 : 1) == -1 && errno != EINTR)
+			break;
+		uint64_t wakeups;
+		while(::read(clientWakeFd, &wakeups, sizeof(wakeups)) > 0) {} // clear
+
+		// from now on, new messages must wake us up again; they may also be picked up by the drain below, which is harmless
+		clientWakePending.store(false, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// messages that were too long for send(), it cannot print from the audio thread
+		unsigned int truncated = truncatedCount.exchange(0, std::memory_order_relaxed);
+		if(truncated > 0)
+			printf("Web socket server warning! %u data buffers were too long and were truncated to %u bytes!\n", truncated, WSSlabSize);
+
+		// until the queue is empty...
+		WSBatch* batch = nullptr;
+		unsigned int recordSize;
+		unsigned int tag;
+		const void* record;
+		while((record = outputs.beginRead(recordSize, tag)) != nullptr)
+		{
+			// unpack
+			const WSOutputData* output = (const WSOutputData*)record;
+			GuiWSHandler* handler = getHandler(output->address);
+			if(handler == nullptr)
 			{
-				// send, via execute
-				if (handler->binary)
-				{
-					// make a copy of the data before we send it out
-					auto data = std::make_shared<std::vector<void*> >(size);
-					memcpy(data->data(), buf, size);
-					handler->server->execute([handler, data, size]{
-						for (auto c : handler->connections){
-							c->send((uint8_t*) data->data(), size);
-						}
-					});
-				} else {
-					// make a copy of the data before we send it out
-					std::string str = (const char*)buf;
-					handler->server->execute([handler, str]{
-						for (auto c : handler->connections){
-							c->send(str.c_str());
-						}
-					});
-				}
-			} catch (std::exception& e) 
+				fprintf(stderr, "Could not send data via web server, unknown address %s\n", output->address);
+				if(tag != 0)
+					releaseSlab(getSlab(tag - 1));
+				outputs.endRead();
+				continue;
+			}
+			unsigned int headerSize = output->headerSize;
+			const char* header = (const char*)(output + 1);
+			unsigned int size = (tag != 0) ? output->slabSize : recordSize - sizeof(WSOutputData) - headerSize;
+			// short messages and headers are copied into the batch, null-terminated
+			unsigned int bytes = ((tag != 0) ? 0 : size + 1) + ((headerSize != 0) ? headerSize + 1 : 0);
+			unsigned int messages = (headerSize != 0) ? 2 : 1;
+
+			// start a new batch if this message [and its header] does not fit in the current one
+			if(batch != nullptr && (batch->numMessages + messages > WSBatch::maxMessages || batch->numBytes + bytes > WSBatch::maxBytes))
 			{
-				std::cerr << "Could not send data via web server, exception caught: " << e.what() << std::endl;
+				flushBatch(batch);
+				batch = nullptr;
 			}
-		}
+			if(batch == nullptr)
+			{
+				batch = takeBatch();
+				if(batch == nullptr)
+					break; // stopping
+			}
+
+			if(headerSize != 0)
+				addToBatch(batch, handler, header, headerSize, -1);
+			// long message, sent straight from its slab, that goes back to the pool only after that
+			if(tag != 0)
+				addToBatch(batch, handler, getSlab(tag - 1), size, tag - 1);
+			else
+				addToBatch(batch, handler, header + headerSize, size, -1);
 
-		usleep(WSServerClientSleepUs);
+			// the data were copied [or the slab handed over], the slot can be reused
+			outputs.endRead();
+		}
+		if(batch != nullptr)
+			flushBatch(batch);
 	}
 	return (void *)0;
 }
 
+// the caller makes sure it fits
+void WSServer::addToBatch(WSBatch* batch, GuiWSHandler* handler, const void* data, unsigned int size, int slab)
+{
+	WSMessage& msg = batch->messages[batch->numMessages++];
+	msg.handler = handler;
+	msg.size = size;
+	msg.slab = slab;
+	if(slab != -1)
+	{
+		msg.data = (const char*)data;
+		return;
+	}
+	msg.data = batch->data + batch->numBytes;
+	memcpy(batch->data + batch->numBytes, data, size);
+	batch->data[batch->numBytes + size] = '\0';
+	batch->numBytes += size + 1;
+}
+
+GuiWSHandler* WSServer::getHandler(const char* address)
+{
+	// same pointer as before and same content, to be safe if the caller's string was replaced
+	for(unsigned int i = 0; i < handlerCacheCount; i++) {
+		if(handlerCache[i].address == address && handlerCache[i].handler->address == address)
+			return handlerCache[i].handler;
+	}
+
+	auto it = address_book.find(address);
+	if(it == address_book.end())
+		return nullptr;
+	GuiWSHandler* handler = it->second.get(); // alive as long as address_book
+	if(handlerCacheCount < handler_cache_size)
+		handlerCache[handlerCacheCount++] = {address, handler};
+	return handler;
+}
+
+// waits if all the batches are with the server thread, the output queue holds the messages meanwhile
+WSBatch* WSServer::takeBatch()
+{
+	WSBatch* batch = spareBatch;
+	spareBatch = nullptr;
+	if(batch != nullptr)
+		return batch;
+	while(!freeBatches.pop(batch))
+	{
+		if(shouldStop)
+			return nullptr;
+		usleep(1000);
+	}
+	return batch;
+}
+
+void WSServer::flushBatch(WSBatch* batch)
+{
+	try
+	{
+		// captures two pointers only, no allocation for the closure
+		server->execute([this, batch]{
+			sendBatch(batch);
+		});
+	} catch (std::exception& e)
+	{
+		std::cerr << "Could not send data via web server, exception caught: " << e.what() << std::endl;
+		// only the server thread returns batches to freeBatches, we keep this one aside
+		clearBatch(batch);
+		spareBatch = batch;
+	}
+}
+
+// server thread
+void WSServer::sendBatch(WSBatch* batch)
+{
+	for(unsigned int i = 0; i < batch->numMessages; i++) {
+		const WSMessage& msg = batch->messages[i];
+		// framed once and shared by all the connections, e.g., several browsers showing the same GUI
+		if (msg.handler->binary)
+			seasocks::WebSocket::broadcast(msg.handler->connections, (const uint8_t*) msg.data, msg.size);
+		else
+			seasocks::WebSocket::broadcast(msg.handler->connections, msg.data);
+	}
+	clearBatch(batch);
+	freeBatches.push(batch);
+}
+
+void WSServer::clearBatch(WSBatch* batch)
+{
+	for(unsigned int i = 0; i < batch->numMessages; i++) {
+		if(batch->messages[i].slab >= 0)
+			releaseSlab(getSlab(batch->messages[i].slab));
+	}
+	batch->numMessages = 0;
+	batch->numBytes = 0;
+}
+
 void* WSServer::client_func_static(void* arg)
 {
 	// set minimum thread niceness
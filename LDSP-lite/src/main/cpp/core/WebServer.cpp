@@ -27,10 +27,6 @@ void WebServer::setup(std::string projectName, std::string serverName, unsigned
     _port = port;
     auto logger = std::make_shared<seasocks::IgnoringLogger>();
 	server = std::make_shared<seasocks::Server>(logger);
-
-    // prepare client loop vars
-    outputs_writePtr.store(-1);
-	outputs_readPtr = -1;
 }
 
 void WebServer::addPageHandler(std::__ndk1::shared_ptr<seasocks::PageHandler> handler) {
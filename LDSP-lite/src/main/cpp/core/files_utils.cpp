@@ -2,6 +2,8 @@
 #include "LDSP_log.h"
 #include <fstream>
 #include <sstream>
+
+#ifdef __ANDROID__
 #include <jni.h>
 
 // Global references for JNI
@@ -9,6 +11,7 @@ extern JavaVM* g_JavaVM;
 extern jobject g_NativeLDSPliteInstance;
 extern jobject g_context;
 extern jobject g_classLoader;
+#endif
 
 
 bool isFirstDirectorySdcard(const std::string& path) {
@@ -35,6 +38,7 @@ std::vector<char> readFile(const std::string& path) {
 
 //  LDSP_log("============== path %s\n", path.c_str());
 
+#ifdef __ANDROID__
   if (!isFirstDirectorySdcard(path)) {
 
     // The path is an asset, call the Java method
@@ -120,8 +124,10 @@ std::vector<char> readFile(const std::string& path) {
     if (shouldDetach) {
       g_JavaVM->DetachCurrentThread();
     }
-  } else {
-    // Regular file system path handling
+  } else
+#endif
+  {
+    // Regular file system path handling [always the case on the host build, where there are no assets]
     std::ifstream file(path, std::ios::binary);
     if (file) {
       content.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
@@ -0,0 +1,84 @@
+#include "interleave_utils.h"
+#include <cstring> // memcpy
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INTERLEAVE_NEON
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define INTERLEAVE_SSE
+#endif
+
+static void deinterleaveStereo(const float *in, float *outL, float *outR, int frames) {
+  int n = 0;
+#if defined(INTERLEAVE_NEON)
+  for(; n+4<=frames; n+=4) {
+    float32x4x2_t lr = vld2q_f32(in + 2*n); // loads and deinterleaves 4 frames at once
+    vst1q_f32(outL + n, lr.val[0]);
+    vst1q_f32(outR + n, lr.val[1]);
+  }
+#elif defined(INTERLEAVE_SSE)
+  for(; n+4<=frames; n+=4) {
+    __m128 a = _mm_loadu_ps(in + 2*n);     // L0 R0 L1 R1
+    __m128 b = _mm_loadu_ps(in + 2*n + 4); // L2 R2 L3 R3
+    _mm_storeu_ps(outL + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(outR + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+#endif
+  // leftovers, or everything if no SIMD
+  for(; n<frames; n++) {
+    outL[n] = in[2*n];
+    outR[n] = in[2*n + 1];
+  }
+}
+
+static void interleaveStereo(const float *inL, const float *inR, float *out, int frames) {
+  int n = 0;
+#if defined(INTERLEAVE_NEON)
+  for(; n+4<=frames; n+=4) {
+    float32x4x2_t lr;
+    lr.val[0] = vld1q_f32(inL + n);
+    lr.val[1] = vld1q_f32(inR + n);
+    vst2q_f32(out + 2*n, lr); // interleaves and stores 4 frames at once
+  }
+#elif defined(INTERLEAVE_SSE)
+  for(; n+4<=frames; n+=4) {
+    __m128 l = _mm_loadu_ps(inL + n);
+    __m128 r = _mm_loadu_ps(inR + n);
+    _mm_storeu_ps(out + 2*n, _mm_unpacklo_ps(l, r));     // L0 R0 L1 R1
+    _mm_storeu_ps(out + 2*n + 4, _mm_unpackhi_ps(l, r)); // L2 R2 L3 R3
+  }
+#endif
+  for(; n<frames; n++) {
+    out[2*n] = inL[n];
+    out[2*n + 1] = inR[n];
+  }
+}
+
+void deinterleave(const float *in, float * const *out, int frames, int channels) {
+  if(channels == 1)
+    memcpy(out[0], in, frames*sizeof(float));
+  else if(channels == 2)
+    deinterleaveStereo(in, out[0], out[1], frames);
+  else {
+    for(int chn=0; chn<channels; chn++) {
+      float *outChn = out[chn];
+      for(int n=0; n<frames; n++)
+        outChn[n] = in[n*channels + chn];
+    }
+  }
+}
+
+void interleave(const float * const *in, float *out, int frames, int channels) {
+  if(channels == 1)
+    memcpy(out, in[0], frames*sizeof(float));
+  else if(channels == 2)
+    interleaveStereo(in[0], in[1], out, frames);
+  else {
+    for(int chn=0; chn<channels; chn++) {
+      const float *inChn = in[chn];
+      for(int n=0; n<frames; n++)
+        out[n*channels + chn] = inChn[n];
+    }
+  }
+}
@@ -213,19 +213,22 @@ JNIEXPORT jbyteArray JNICALL Java_com_ldsp_ldsplite_NativeLDSPlite_readFileFromA
 
 
 
+// parameters, sliders included
+
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider0(JNIEnv *env,
-                                                jobject thiz,
-                                                jlong ldspLiteHandle,
-                                                jfloat value) {
+Java_com_ldsp_ldsplite_NativeLDSPlite_setParameter(JNIEnv *env,
+                                                  jobject thiz,
+                                                  jlong ldspLiteHandle,
+                                                  jint index,
+                                                  jfloat value) {
   auto* ldspLite =
       reinterpret_cast<ldsplite::LDSPlite*>(
           ldspLiteHandle);
   const auto nativeValue = static_cast<float>(value);
 
   if (ldspLite) {
-    ldspLite->setSlider0(nativeValue);
+    ldspLite->setParameter(index, nativeValue);
   } else {
     LDSP_log(
         "LDSPlite not created. Please, create it first by "
@@ -235,17 +238,17 @@ Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider0(JNIEnv *env,
 
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider1(JNIEnv *env,
-                                                jobject thiz,
-                                                jlong ldspLiteHandle,
-                                                jfloat value) {
+Java_com_ldsp_ldsplite_NativeLDSPlite_setParameterSmoothing(JNIEnv *env,
+                                                           jobject thiz,
+                                                           jlong ldspLiteHandle,
+                                                           jint index,
+                                                           jfloat rampMs) {
   auto* ldspLite =
       reinterpret_cast<ldsplite::LDSPlite*>(
           ldspLiteHandle);
-  const auto nativeValue = static_cast<float>(value);
 
   if (ldspLite) {
-    ldspLite->setSlider1(nativeValue);
+    ldspLite->setParameterSmoothing(index, rampMs);
   } else {
     LDSP_log(
         "LDSPlite not created. Please, create it first by "
@@ -253,46 +256,325 @@ Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider1(JNIEnv *env,
   }
 }
 
+
+// audio settings
+
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider2(JNIEnv *env,
-                                                jobject thiz,
-                                                jlong ldspLiteHandle,
-                                                jfloat value) {
+Java_com_ldsp_ldsplite_NativeLDSPlite_setAudioSettings(JNIEnv *env,
+                                                      jobject thiz,
+                                                      jlong ldspLiteHandle,
+                                                      jint periodSize,
+                                                      jfloat samplerate,
+                                                      jint bufferCapacityMult,
+                                                      jint performanceMode) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->setAudioSettings(periodSize, samplerate, bufferCapacityMult, performanceMode);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_setChannelCounts(JNIEnv *env,
+                                                      jobject thiz,
+                                                      jlong ldspLiteHandle,
+                                                      jint inChannels,
+                                                      jint outChannels) {
   auto* ldspLite =
       reinterpret_cast<ldsplite::LDSPlite*>(
           ldspLiteHandle);
-  const auto nativeValue = static_cast<float>(value);
 
   if (ldspLite) {
-    ldspLite->setSlider2(nativeValue);
+    return ldspLite->setChannelCounts(inChannels, outChannels);
   } else {
     LDSP_log(
         "LDSPlite not created. Please, create it first by "
         "calling create().");
+    return false;
   }
 }
 
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_ldsp_ldsplite_NativeLDSPlite_setSlider3(JNIEnv *env,
-                                                jobject thiz,
-                                                jlong ldspLiteHandle,
-                                                jfloat value) {
+Java_com_ldsp_ldsplite_NativeLDSPlite_setRenderBlockSize(JNIEnv *env,
+                                                        jobject thiz,
+                                                        jlong ldspLiteHandle,
+                                                        jint frames) {
   auto* ldspLite =
       reinterpret_cast<ldsplite::LDSPlite*>(
           ldspLiteHandle);
-  const auto nativeValue = static_cast<float>(value);
 
   if (ldspLite) {
-    ldspLite->setSlider3(nativeValue);
+    ldspLite->setRenderBlockSize(frames);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getRenderBlockLatency(JNIEnv *env,
+                                                           jobject thiz,
+                                                           jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    return ldspLite->getRenderBlockLatency();
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+    return 0;
+  }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_setLatencyTuning(JNIEnv *env,
+                                                      jobject thiz,
+                                                      jlong ldspLiteHandle,
+                                                      jboolean enabled) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->setLatencyTuning(enabled);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getLatencyTunerState(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    return ldspLite->getLatencyTunerState();
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+    return 0;
+  }
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getOutputBufferSize(JNIEnv *env,
+                                                         jobject thiz,
+                                                         jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    return ldspLite->getOutputBufferSize();
   } else {
     LDSP_log(
         "LDSPlite not created. Please, create it first by "
         "calling create().");
+    return -1;
   }
 }
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_setDriftCompensation(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong ldspLiteHandle,
+                                                          jboolean enabled) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->setDriftCompensation(enabled);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+// stats are packed as [ratio, fillLevel, targetFillLevel, underflows, overflows]
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getDriftStats(JNIEnv *env,
+                                                   jobject thiz,
+                                                   jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  const int length = 5;
+  jdouble buffer[length] = {0};
+
+  if (ldspLite) {
+    DriftCompensatorStats stats;
+    ldspLite->getDriftStats(stats);
+    buffer[0] = stats.ratio;
+    buffer[1] = stats.fillLevel;
+    buffer[2] = stats.targetFillLevel;
+    buffer[3] = stats.underflows;
+    buffer[4] = stats.overflows;
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+
+  jdoubleArray result = env->NewDoubleArray(length);
+  env->SetDoubleArrayRegion(result, 0, length, buffer);
+  return result;
+}
+
+
+// sensors
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_setSensorRate(JNIEnv *env,
+                                                   jobject thiz,
+                                                   jlong ldspLiteHandle,
+                                                   jint sensor,
+                                                   jfloat rate) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->setSensorRate(static_cast<int>(sensor), static_cast<float>(rate));
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+// one entry per LDSP_sensor, empty if sensors are not running
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getSensorRates(JNIEnv *env,
+                                                    jobject thiz,
+                                                    jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  float rates[LDSP_sensorsMax];
+  jdouble buffer[LDSP_sensorsMax];
+  int length = 0;
+
+  if (ldspLite) {
+    length = ldspLite->getSensorRates(rates, LDSP_sensorsMax);
+    for (int i = 0; i < length; i++)
+      buffer[i] = rates[i];
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+
+  jdoubleArray result = env->NewDoubleArray(length);
+  env->SetDoubleArrayRegion(result, 0, length, buffer);
+  return result;
+}
+
+
+// render timing
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_setRenderTimingEnabled(JNIEnv *env,
+                                                            jobject thiz,
+                                                            jlong ldspLiteHandle,
+                                                            jboolean enabled) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->setRenderTimingEnabled(enabled);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_resetRenderTiming(JNIEnv *env,
+                                                       jobject thiz,
+                                                       jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->resetRenderTiming();
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
+// stats are packed as [callbacks, meanLoad, worstLoad, overruns, xruns, histogram bins...]
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_getRenderTimingStats(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong ldspLiteHandle) {
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  const int headerLen = 5;
+  const int length = headerLen + ldsplite::RenderTimingStats::histogramBins;
+  jdouble buffer[length] = {0};
+
+  if (ldspLite) {
+    ldsplite::RenderTimingStats stats;
+    ldspLite->getRenderTimingStats(stats);
+    buffer[0] = stats.callbacks;
+    buffer[1] = stats.meanLoad;
+    buffer[2] = stats.worstLoad;
+    buffer[3] = stats.overruns;
+    buffer[4] = stats.xruns;
+    for (int i = 0; i < ldsplite::RenderTimingStats::histogramBins; i++)
+      buffer[headerLen + i] = stats.histogram[i];
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+
+  jdoubleArray result = env->NewDoubleArray(length);
+  env->SetDoubleArrayRegion(result, 0, length, buffer);
+  return result;
+}
+
 
 // multitouch
 
@@ -355,6 +637,37 @@ Java_com_ldsp_ldsplite_NativeLDSPlite_updateTouch(
   }
 }
 
+// buffer is a direct ByteBuffer in native byte order, holding count records of TouchHandler::BATCH_RECORD_SIZE floats
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_updateTouchBatch(
+    JNIEnv* env,
+    jobject thiz,
+    jlong ldspLiteHandle,
+    jobject buffer,
+    jint count,
+    jint anyTouch) {
+
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    // no copy, we read straight from the Java buffer
+    auto* records = static_cast<const float*>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (records == nullptr || capacity < (jlong)count * ldsplite::TouchHandler::BATCH_RECORD_SIZE * (jlong)sizeof(float)) {
+      LDSP_log("updateTouchBatch() needs a direct buffer big enough for %d records", count);
+      return;
+    }
+    ldspLite->updateTouchBatch(records, count, anyTouch);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
+
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_ldsp_ldsplite_NativeLDSPlite_updateHover(
@@ -424,4 +737,27 @@ Java_com_ldsp_ldsplite_NativeLDSPlite_setScreenResolution(
         "LDSPlite not created. Please, create it first by "
         "calling create().");
   }
-}
\ No newline at end of file
+}
+
+// channel is one of btnInputChannel, key repeats can be passed in as they are ignored
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_ldsp_ldsplite_NativeLDSPlite_updateButton(
+    JNIEnv* env,
+    jobject thiz,
+    jlong ldspLiteHandle,
+    jint channel,
+    jboolean pressed) {
+
+  auto* ldspLite =
+      reinterpret_cast<ldsplite::LDSPlite*>(
+          ldspLiteHandle);
+
+  if (ldspLite) {
+    ldspLite->updateButton(static_cast<int>(channel), pressed == JNI_TRUE);
+  } else {
+    LDSP_log(
+        "LDSPlite not created. Please, create it first by "
+        "calling create().");
+  }
+}
@@ -1,14 +1,20 @@
 
 #include <iostream>
-#include <unistd.h> // for usleep()
+#include <pthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <time.h>
 
 #include "sensors.h"
 #include "LDSP.h"
+#include "thread_utils.h"
 
 using namespace ldsplite;
 
 bool sensorsVerbose = false;
 bool sensorsOff = false;
+float sensorsTargetRates[LDSP_sensorsMax]; // from settings, see LDSPinitSettings::sensorRates
+float sensorsBlockRate = 0;
 
 LDSPsensorsContext sensorsContext;
 //LDSPinternalContext intContext; // moved to OboeAudioEngine.cpp
@@ -16,13 +22,37 @@ LDSPsensorsContext sensorsContext;
 ASensorManager *sensor_manager;
 ASensorEventQueue *event_queue;
 
+// the sensor thread blocks on its looper, reads events in batches and pushes them into the ring
+// the audio thread drains the ring once per block [updateSensors()], so it never calls into the sensor service
+constexpr int sensorsLooperId = 1; // returned by ALooper_pollOnce() when the event queue has data
+constexpr int sensorsBatchSize = 64; // events per ASensorEventQueue_getEvents() call
+SpscRing<sensor_sample, 1024> sensorRing; // several periods worth of events, even with all sensors at max rate
+
+pthread_t sensor_thread;
+ALooper *sensor_looper = nullptr;
+std::atomic<bool> sensorsShouldStop{false};
+// to wait until the thread has its event queue up and running
+std::mutex sensorsReadyMutex;
+std::condition_variable sensorsReadyCond;
+bool sensorsReady = false;
+// samples also go out as timestamped control events, see setSensorEventCallback()
+std::function<void(int64_t, const sensor_sample &)> sensorEventCallback;
+
 void initSensors();
 void initSensorBuffers();
+void startSensorThread();
+void stopSensorThread();
+void enableSensors();
+void disableSensors();
+int sensorPeriod(int sensorIndex);
 
 void LDSP_initSensors(LDSPinitSettings *settings)
 {
   sensorsVerbose = settings->verbose;
   sensorsOff = settings->sensorsOff;
+  for(int i=0; i<LDSP_sensorsMax; i++)
+    sensorsTargetRates[i] = settings->sensorRates[i];
+  sensorsBlockRate = settings->samplerate / settings->periodSize;
 
   if(sensorsVerbose && !sensorsOff)
     LDSP_log("\nLDSP_initSensors()\n");
@@ -41,19 +71,9 @@ void LDSP_initSensors(LDSPinitSettings *settings)
   //VIC user context is reference of this internal one, so no need to update it
 
   // if sensors are off, nothing else to do
+  // otherwise, data start flowing as soon as the thread enables the sensors, and the audio thread picks them up at each block
   if(!sensorsOff)
-  {
-    // read a couple of times, to make sure we have some sensor data once our audio application starts
-    readSensors();
-    usleep(200000); // 200 ms
-    readSensors();
-    // if non full duplex engine, we need to read an extra time, becuase initAudio() will take less time
-    if(settings->captureOff)
-    {
-      usleep(200000); // 200 ms
-      readSensors();
-    }
-  }
+    startSensorThread();
 }
 
 void LDSP_cleanupSensors()
@@ -61,33 +81,29 @@ void LDSP_cleanupSensors()
   if(sensorsVerbose && !sensorsOff)
     LDSP_log("LDSP_cleanupSensors()\n");
 
-  // disable present sensors and deallocate channels
-  for(int i=0; i<sensorsContext.sensorsCount; i++)
+  // the thread disables present sensors and deallocates the queue on its way out, only if sensors were on
+  if(!sensorsOff)
   {
-    if(sensorsContext.sensors[i].present)
-    {
-      ASensorEventQueue_disableSensor(event_queue, sensorsContext.sensors[i].asensor); //VIC on some phones this causes a crash, but its absence does not have any effect
-      // the problem is that if we don't call it, on the same phones sometimes in the next run we cannot activate sensors... and we need to reboot
-      // can be done more quickly via:
-      // adb shell am broadcast -a android.intent.action.BOOT_COMPLETED
-      // we may as well keep it here and reboot sometimes
+    stopSensorThread();
 
-      // the following check does the same
-      /* LDSP_sensor sensor_type = (LDSP_sensor::_enum)LDSP_sensor::_from_index(i);
-      if(ASensorEventQueue_disableSensor(event_queue, sensorsContext.sensors[i].asensor) == 0)
+    if(sensorsVerbose)
+    {
+      for(int i=0; i<sensorsContext.sensorsCount; i++)
       {
-          if(sensorsVerbose)
-              LDSP_log("\t %s disabled!\n", sensor_type._to_string());
+        sensor_struct& sens_struct = sensorsContext.sensors[i];
+        if(sens_struct.present)
+          LDSP_log("\t%s rate: requested %.1f Hz, effective %.1f Hz\n", sensors_info[i].name,
+                   sens_struct.requestedRate, sens_struct.effectiveRate.load());
       }
-      else
-          LDSP_log("\t Warning! Could not disable the following sensor: %s\n", sensor_type._to_string()); */
-      delete[] sensorsContext.sensors[i].channels;
     }
   }
 
-  // deallocate queue, only if sensors were on
-  if(!sensorsOff)
-    ASensorManager_destroyEventQueue(sensor_manager, event_queue);
+  // deallocate channels
+  for(int i=0; i<sensorsContext.sensorsCount; i++)
+  {
+    if(sensorsContext.sensors[i].present)
+      delete[] sensorsContext.sensors[i].channels;
+  }
 
   // daallocated sensor buffers
   if(sensorsContext.sensorBuffer != nullptr)
@@ -109,11 +125,11 @@ void initSensors()
 #else
   sensor_manager = ASensorManager_getInstance();
 #endif
-  ALooper *looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
-  event_queue = ASensorManager_createEventQueue(sensor_manager, looper, 1, NULL, NULL);
+  // the event queue is created by the sensor thread, on its own looper
 
-  //sensorsContext.sensorsCount = 0;
-  int channelIndex = 0;
+  // from scratch at each start
+  sensorsContext.sensorsCount = 0;
+  sensorsContext.sensorsType_index.clear();
 
   if(sensorsVerbose)
     LDSP_log("Sensor list:\n");
@@ -122,19 +138,24 @@ void initSensors()
   {
     sensorsContext.sensorsCount++; // to avoid using LDSP_sensor::count anymore
 
-    LDSP_sensor sensor_type = (LDSP_sensor::_enum)LDSP_sensor::_from_index(i);
-    const ASensor *sensor = ASensorManager_getDefaultSensor(sensor_manager, sensor_type);
+    const sensor_info &info = sensors_info[i];
+    // sensors the phone does not have, including those its Android version does not know of, come back as NULL
+    const ASensor *sensor = ASensorManager_getDefaultSensor(sensor_manager, info.type);
     sensor_struct& sens_struct = sensorsContext.sensors[i];
 
-    sens_struct.numOfChannels = atoi(sensors_channelsInfo[i][0].c_str());
+    sens_struct.numOfChannels = info.numOfChannels;
+    sens_struct.timestamp = 0;
+    sens_struct.requestedRate = 0;
+    sens_struct.effectiveRate = 0;
+    sens_struct.rateWindowStart = 0;
+    sens_struct.rateWindowEvents = 0;
 
     if(sensor == NULL)
     {
       // skip sensor
       sens_struct.present = false;
-      channelIndex += sens_struct.numOfChannels;
       if(sensorsVerbose)
-        LDSP_log("\t%s not present ):\n", sensor_type._to_string());
+        LDSP_log("\t%s not present ):\n", info.name);
     }
     else
     {
@@ -144,16 +165,17 @@ void initSensors()
       sens_struct.type = ASensor_getType(sensor);
       sens_struct.channels = (sensorChannel*) new unsigned int[sens_struct.numOfChannels];
       for(int chn=0; chn<sens_struct.numOfChannels; chn++)
-        sens_struct.channels[chn] = (sensorChannel)channelIndex++;
+        sens_struct.channels[chn] = (sensorChannel)(info.firstChannel + chn);
 
       sensorsContext.sensorsType_index[sens_struct.type] = i; // to quickly find this sensors in array
 
       // zero means that zero means that this sensor doesn't report events at a constant rate, but rather only when a new data is available
       int minDelay = ASensor_getMinDelay(sensor);
+      sens_struct.minDelay = minDelay;
 
       if(sensorsVerbose)
       {
-        LDSP_log("\t%s present!\n", sensor_type._to_string());
+        LDSP_log("\t%s present!\n", info.name);
         LDSP_log("\t\tvendor and name: %s, %s\n", ASensor_getVendor(sensor), ASensor_getName(sensor));
         LDSP_log("\t\tresolution: %f\n", ASensor_getResolution(sensor));
         if(minDelay != 0)
@@ -161,13 +183,6 @@ void initSensors()
         else
           LDSP_log("\t\trate based on data availability\n");
       }
-
-      ASensorEventQueue_enableSensor(event_queue, sensor);
-      // we don't set a rate for sensors that report on new event only, otherwise on some phones we may get crashes
-      if(minDelay != 0)
-        ASensorEventQueue_setEventRate(event_queue, sensor, 100); // symbolic 100 us sampling period... to make sure we request max rate
-      //VIC there is an android API function that is supposed to return the min period supported, ASensor_getMinDelay()
-      // but the doc says its value is often an underestimation: https://developer.android.com/ndk/reference/group/sensor#asensoreventqueue_seteventrate
     }
   }
 }
@@ -186,11 +201,8 @@ void initSensorBuffers()
   {
     // extract it along with its name and info
     sensor_struct *sens_struct = &sensorsContext.sensors[sens];
-    LDSP_sensor sensor_type_name = (LDSP_sensor::_enum)LDSP_sensor::_from_index(sens);
-    string name = sensor_type_name._to_string();
-    string descr = sensors_channelsInfo[sens][1];
-    string delimiter = ", ";
-    size_t pos = 0;
+    const sensor_info &info = sensors_info[sens];
+    string name = info.name;
 
     // for each channel in the sensor...
     for(int chn=0; chn<sens_struct->numOfChannels; chn++)
@@ -205,12 +217,7 @@ void initSensorBuffers()
         sensorsContext.sensorSupported[chnCnt] = false;
 
       // init type
-      // in case sensors has more channels, pick the description of the current channel
-      pos = descr.find(delimiter); // channel decsriptions are separated by ", "
-      string chnDescr = descr.substr(0, pos);
-      descr = descr.substr(pos + delimiter.length());
-
-      sensorsContext.sensorsDetails[chnCnt] = name + ", sensing " + chnDescr;
+      sensorsContext.sensorsDetails[chnCnt] = name + ", sensing " + info.channelsDetails[chn];
 
       chnCnt++;
     }
@@ -227,52 +234,182 @@ void initSensorBuffers()
 
 void readSensors()
 {
-  ASensorEvent event;
+  ASensorEvent events[sensorsBatchSize];
+  ssize_t numEvents;
 
   // get most current events, if any
-  while(ASensorEventQueue_getEvents(event_queue, &event, 1) > 0)
+  while((numEvents = ASensorEventQueue_getEvents(event_queue, events, sensorsBatchSize)) > 0)
+  {
+    // Android stamps sensor events with the boot time clock [elapsedRealtimeNanos()], control events use a monotonic clock that stops in deep sleep
+    struct timespec bootNow;
+    clock_gettime(CLOCK_BOOTTIME, &bootNow);
+    int64_t bootToCtrlClock = monotonic_ns() - (bootNow.tv_sec * (int64_t)1000000000 + bootNow.tv_nsec);
+
+    for(int e=0; e<numEvents; e++)
+    {
+      const ASensorEvent &event = events[e];
+      auto it = sensorsContext.sensorsType_index.find(event.type);
+      if(it == sensorsContext.sensorsType_index.end())
+        continue; // not one of ours
+
+      sensor_sample sample = {}; // channels the sensor does not have stay 0
+      sample.timestamp = event.timestamp;
+      sample.sensorIndex = it->second; // get index of sensors of this type
+      sensor_struct& sensor = sensorsContext.sensors[sample.sensorIndex];
+      for(int chn=0; chn<sensor.numOfChannels; chn++)
+        sample.data[chn] = event.data[chn];
+
+      // effective rate, over windows of about a second
+      if(sensor.rateWindowEvents == 0)
+        sensor.rateWindowStart = event.timestamp;
+      else if(event.timestamp - sensor.rateWindowStart >= 1000000000)
+      {
+        sensor.effectiveRate.store(sensor.rateWindowEvents * 1e9f / (event.timestamp - sensor.rateWindowStart), std::memory_order_relaxed);
+        sensor.rateWindowStart = event.timestamp;
+        sensor.rateWindowEvents = 0;
+      }
+      sensor.rateWindowEvents++;
+
+      // if the audio thread is not keeping up, this is dropped, newer samples will follow anyway
+      sensorRing.push(sample);
+      if(sensorEventCallback)
+        sensorEventCallback(event.timestamp + bootToCtrlClock, sample);
+    }
+  }
+}
+
+void updateSensors()
+{
+  if(sensorsOff)
+    return;
+
+  // samples are applied in order, so each channel ends up with the latest value
+  sensor_sample sample;
+  while(sensorRing.pop(sample))
   {
-    int idx = sensorsContext.sensorsType_index[event.type]; // get index of sensors of this type
-    sensor_struct& sensor = sensorsContext.sensors[idx]; // get sensor of this type
+    sensor_struct& sensor = sensorsContext.sensors[sample.sensorIndex]; // get sensor of this type
     // fill sensorBuffer with sensor data, in the channels reserved to this type of sensor
-    // normalized sensor
-    // if(sensors_max[idx] > 0)
-    // {
-    //     for(int chn=0; chn<sensor.numOfChannels; chn++)
-    //     {
-    //         float val = constrain(event.data[chn], -sensors_max[idx], sensors_max[idx]);
-    //         val /= sensors_max[idx];
-    //         sensorsContext.sensorBuffer[sensor.channels[chn]] = val;
-    //     }
-    // }
-    // else // non-normalized sensor
-    // {
     for(int chn=0; chn<sensor.numOfChannels; chn++)
-      sensorsContext.sensorBuffer[sensor.channels[chn]] = event.data[chn];
-    // }
-
-    // if(event.type == ASENSOR_TYPE_ACCELEROMETER)
-    // {
-    //     float ar = event.data[0];
-    //     float br = event.data[1];
-    //     float cr = event.data[2];
-    //     LDSP_log("sensor raw: %f, %f, %f\n", ar, br, cr);
-
-    //     float a = sensorsContext.sensorBuffer[sensor.channels[0]];
-    //     float b = sensorsContext.sensorBuffer[sensor.channels[1]];
-    //     float c = sensorsContext.sensorBuffer[sensor.channels[2]];
-    //     LDSP_log("sensor: %f, %f, %f\n", a, b, c);
-    // }
-
-    // if(event.type == ASENSOR_TYPE_LIGHT)
-    // {
-    //     float ar = event.data[0];
-    //     LDSP_log("sensor light: %f\n", ar);
-    // }
-    // if(event.type == ASENSOR_TYPE_PROXIMITY)
-    // {
-    //     float ar = event.data[0];
-    //     LDSP_log("sensor prox: %f\n", ar);
-    // }
+      sensorsContext.sensorBuffer[sensor.channels[chn]] = sample.data[chn];
+    sensor.timestamp = sample.timestamp;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void *sensor_func(void *)
+{
+  set_priority(LDSPprioOrder_ctrlInputs, sensorsVerbose);
+
+  // the queue is bound to the looper of this thread, so that we can block on it here
+  sensor_looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+  event_queue = ASensorManager_createEventQueue(sensor_manager, sensor_looper, sensorsLooperId, NULL, NULL);
+  enableSensors();
+
+  {
+    std::lock_guard<std::mutex> lock(sensorsReadyMutex);
+    sensorsReady = true;
   }
-}
\ No newline at end of file
+  sensorsReadyCond.notify_all();
+
+  while(!sensorsShouldStop.load())
+  {
+    // sleeps until some events come in, or stopSensorThread() wakes us up
+    if(ALooper_pollOnce(-1, NULL, NULL, NULL) == sensorsLooperId)
+      readSensors();
+  }
+
+  disableSensors();
+  ASensorManager_destroyEventQueue(sensor_manager, event_queue);
+  return (void *)0;
+}
+
+void startSensorThread()
+{
+  // leftovers from the previous run
+  sensorRing.clear();
+
+  sensorsShouldStop = false;
+  sensorsReady = false;
+  pthread_create(&sensor_thread, NULL, sensor_func, NULL);
+
+  // make sure sensors are enabled before the audio starts
+  std::unique_lock<std::mutex> lock(sensorsReadyMutex);
+  sensorsReadyCond.wait(lock, [] { return sensorsReady; });
+}
+
+void stopSensorThread()
+{
+  sensorsShouldStop = true;
+  ALooper_wake(sensor_looper);
+  pthread_join(sensor_thread, NULL);
+  sensor_looper = nullptr;
+}
+
+void enableSensors()
+{
+  for(int i=0; i<sensorsContext.sensorsCount; i++)
+  {
+    sensor_struct& sens_struct = sensorsContext.sensors[i];
+    if(!sens_struct.present)
+      continue;
+
+    ASensorEventQueue_enableSensor(event_queue, sens_struct.asensor);
+    // we don't set a rate for sensors that report on new event only, otherwise on some phones we may get crashes
+    if(sens_struct.minDelay != 0)
+    {
+      int period = sensorPeriod(i);
+      ASensorEventQueue_setEventRate(event_queue, sens_struct.asensor, period);
+      sens_struct.requestedRate = 1000000.0f / period;
+      if(sensorsVerbose)
+        LDSP_log("\t%s period set to %d us\n", sensors_info[i].name, period);
+    }
+  }
+}
+
+// sampling period to request [us], based on the target rate and the fastest the sensor can go
+int sensorPeriod(int sensorIndex)
+{
+  int minDelay = sensorsContext.sensors[sensorIndex].minDelay;
+  float rate = sensorsTargetRates[sensorIndex];
+  if(rate == sensorRate_block)
+    rate = sensorsBlockRate;
+
+  // there is no point in going faster than the sensor, and asking for it makes some drivers misbehave
+  //VIC the doc says that ASensor_getMinDelay() is often an underestimation: https://developer.android.com/ndk/reference/group/sensor#asensoreventqueue_seteventrate
+  // so the actual rate may be lower, see effectiveRate
+  if(rate <= 0)
+    return minDelay;
+  int period = (int)(1000000.0f / rate);
+  return (period > minDelay) ? period : minDelay;
+}
+
+void setSensorEventCallback(std::function<void(int64_t timeNs, const sensor_sample &sample)> callback)
+{
+  sensorEventCallback = callback;
+}
+
+int getSensorRates(float *rates, int count)
+{
+  if(sensorsOff)
+    return 0;
+  int n = (count < sensorsContext.sensorsCount) ? count : sensorsContext.sensorsCount;
+  for(int i=0; i<n; i++)
+    rates[i] = sensorsContext.sensors[i].present ? sensorsContext.sensors[i].effectiveRate.load(std::memory_order_relaxed) : 0;
+  return n;
+}
+
+void disableSensors()
+{
+  for(int i=0; i<sensorsContext.sensorsCount; i++)
+  {
+    if(sensorsContext.sensors[i].present)
+    {
+      ASensorEventQueue_disableSensor(event_queue, sensorsContext.sensors[i].asensor); //VIC on some phones this causes a crash, but its absence does not have any effect
+      // the problem is that if we don't call it, on the same phones sometimes in the next run we cannot activate sensors... and we need to reboot
+      // can be done more quickly via:
+      // adb shell am broadcast -a android.intent.action.BOOT_COMPLETED
+      // we may as well keep it here and reboot sometimes
+    }
+  }
+}
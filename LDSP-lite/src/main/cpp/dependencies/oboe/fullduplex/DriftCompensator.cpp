@@ -0,0 +1,124 @@
+// This code is part of LDSPlite, written by Victor Zappi
+// it extends the full-duplex stream based on AOSP's Oboe library
+
+#include <cstring>
+#include <cmath>
+#include "DriftCompensator.h"
+
+void DriftCompensator::reset(int32_t channelCount, int32_t capacityFrames, int32_t targetFillLevel) {
+    if (channelCount != mChannelCount || capacityFrames != mCapacityFrames) {
+        mBuffer = std::make_unique<float[]>(capacityFrames * channelCount);
+        mChannelCount = channelCount;
+        mCapacityFrames = capacityFrames;
+    }
+    mTargetFillLevel = targetFillLevel + kGuardFrames;
+    mFillLevel = 0;
+    mPhase = 0;
+    mSmoothedFillLevel = mTargetFillLevel;
+    mIntegral = 0;
+    mRatio = 1;
+    mPrimed = false;
+
+    mStatsRatio.store(1, std::memory_order_relaxed);
+    mStatsFillLevel.store(0, std::memory_order_relaxed);
+    mStatsTargetFillLevel.store(mTargetFillLevel, std::memory_order_relaxed);
+    mUnderflows.store(0, std::memory_order_relaxed);
+    mOverflows.store(0, std::memory_order_relaxed);
+}
+
+void DriftCompensator::advanceWrite(int32_t numFrames) {
+    mFillLevel += numFrames;
+    // the caller cannot write more than getWritableFrames(), so a full fifo means input is piling up
+    if (mFillLevel >= mCapacityFrames) {
+        // drop the oldest half, better a click now than a growing delay
+        dropOldest(mCapacityFrames / 2);
+        mOverflows.store(mOverflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+void DriftCompensator::process(float *output, int32_t numFrames) {
+    // last frame we need to interpolate the end of this block
+    int32_t framesNeeded = (int32_t) (mPhase + (numFrames - 1) * mRatio) + 2;
+
+    if (!mPrimed) {
+        // wait for the cushion to build up before starting
+        mPrimed = (mFillLevel >= mTargetFillLevel && mFillLevel >= framesNeeded);
+        if (mPrimed) {
+            // start exactly at the target, any excess would only add latency and wind up the controller
+            dropOldest(mFillLevel - mTargetFillLevel);
+            mSmoothedFillLevel = mTargetFillLevel;
+            framesNeeded = (int32_t) (mPhase + (numFrames - 1) * mRatio) + 2;
+        }
+    }
+    if (!mPrimed || mFillLevel < framesNeeded) {
+        if (mPrimed) {
+            mUnderflows.store(mUnderflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        mPrimed = false;
+        memset(output, 0, numFrames * mChannelCount * sizeof(float));
+        mStatsFillLevel.store(mFillLevel, std::memory_order_relaxed);
+        return;
+    }
+
+    updateRatio(numFrames);
+    framesNeeded = (int32_t) (mPhase + (numFrames - 1) * mRatio) + 2;
+    if (framesNeeded > mFillLevel && numFrames > 1) {
+        // the new ratio asks for slightly more than we have, stay where we were for this block
+        mRatio = (mFillLevel - 2 - mPhase) / (numFrames - 1);
+    }
+
+    // linear interpolation
+    const float *input = mBuffer.get();
+    double position = mPhase;
+    for (int32_t n = 0; n < numFrames; n++) {
+        int32_t index = (int32_t) position;
+        float frac = (float) (position - index);
+        const float *frame = input + index * mChannelCount;
+        for (int32_t chn = 0; chn < mChannelCount; chn++) {
+            float current = frame[chn];
+            float next = frame[chn + mChannelCount];
+            output[n * mChannelCount + chn] = current + frac * (next - current);
+        }
+        position += mRatio;
+    }
+
+    // shift out what we consumed, keep the fractional part for the next block
+    int32_t consumedFrames = (int32_t) position;
+    mPhase = position - consumedFrames;
+    dropOldest(consumedFrames);
+}
+
+void DriftCompensator::getStats(DriftCompensatorStats &stats) const {
+    stats.ratio = mStatsRatio.load(std::memory_order_relaxed);
+    stats.fillLevel = mStatsFillLevel.load(std::memory_order_relaxed);
+    stats.targetFillLevel = mStatsTargetFillLevel.load(std::memory_order_relaxed);
+    stats.underflows = mUnderflows.load(std::memory_order_relaxed);
+    stats.overflows = mOverflows.load(std::memory_order_relaxed);
+}
+
+void DriftCompensator::dropOldest(int32_t numFrames) {
+    if (numFrames <= 0) {
+        return;
+    }
+    mFillLevel -= numFrames;
+    memmove(mBuffer.get(), mBuffer.get() + numFrames * mChannelCount,
+            mFillLevel * mChannelCount * sizeof(float));
+}
+
+void DriftCompensator::updateRatio(int32_t numFrames) {
+    mSmoothedFillLevel += kFillSmoothing * (mFillLevel - mSmoothedFillLevel);
+
+    // more input than wanted -> consume faster, i.e., ratio above 1
+    double error = (mSmoothedFillLevel - mTargetFillLevel) / numFrames;
+    mIntegral += error;
+    if (mIntegral > kMaxIntegral) mIntegral = kMaxIntegral;
+    if (mIntegral < -kMaxIntegral) mIntegral = -kMaxIntegral;
+
+    double correction = kProportionalGain * error + kIntegralGain * mIntegral;
+    if (correction > kMaxCorrection) correction = kMaxCorrection;
+    if (correction < -kMaxCorrection) correction = -kMaxCorrection;
+    mRatio = 1 + correction;
+
+    mStatsRatio.store(mRatio, std::memory_order_relaxed);
+    mStatsFillLevel.store((int32_t) lround(mSmoothedFillLevel), std::memory_order_relaxed);
+}
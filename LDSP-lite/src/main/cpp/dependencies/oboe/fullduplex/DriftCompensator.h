@@ -0,0 +1,82 @@
+// This code is part of LDSPlite, written by Victor Zappi
+// it extends the full-duplex stream based on AOSP's Oboe library
+
+#ifndef LDSP_DRIFT_COMPENSATOR_H
+#define LDSP_DRIFT_COMPENSATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+struct DriftCompensatorStats {
+    double ratio; // input frames consumed per output frame
+    int32_t fillLevel; // smoothed, in frames
+    int32_t targetFillLevel;
+    uint32_t underflows; // callbacks filled with silence because the fifo ran dry
+    uint32_t overflows; // times input was dropped because the fifo was full
+};
+
+/**
+ * Input and output streams may run on slightly different clocks, so over a long session the input
+ * either piles up or runs dry. This fifo sits between the two: the input stream writes whatever it has,
+ * while the output callback pulls exactly the frames it needs, linearly resampled with a ratio that a
+ * PI controller keeps adjusting so that the fill level stays at a target.
+ *
+ * Everything but getStats() must be called from the audio callback.
+ */
+class DriftCompensator {
+public:
+    /**
+     * @param channelCount interleaved channels
+     * @param capacityFrames size of the fifo
+     * @param targetFillLevel frames that should be in the fifo right before each process(), a few guard frames are added
+     */
+    void reset(int32_t channelCount, int32_t capacityFrames, int32_t targetFillLevel);
+
+    // where new input frames go
+    float *getWriteBuffer() {
+        return mBuffer.get() + mFillLevel * mChannelCount;
+    }
+    int32_t getWritableFrames() const {
+        return mCapacityFrames - mFillLevel;
+    }
+    void advanceWrite(int32_t numFrames);
+
+    // produces numFrames resampled frames, or silence if there is not enough input yet
+    void process(float *output, int32_t numFrames);
+
+    // any thread
+    void getStats(DriftCompensatorStats &stats) const;
+
+private:
+    // the controller reacts to the fill level error, measured in callbacks
+    // tiny gains: clock drift is in the order of 100 ppm and we want the correction to be inaudible
+    static constexpr double kProportionalGain = 1.0e-2;
+    static constexpr double kIntegralGain = 3.0e-5;
+    static constexpr double kMaxIntegral = 5.0e3; // anti-windup, in callbacks
+    static constexpr double kMaxCorrection = 0.005; // +/- 0.5%
+    static constexpr double kFillSmoothing = 0.02; // one-pole smoothing of the fill level, input often comes in bursts
+    static constexpr int32_t kGuardFrames = 4; // on top of the target, linear interpolation reads one frame ahead
+
+    std::unique_ptr<float[]> mBuffer;
+    int32_t mChannelCount = 0;
+    int32_t mCapacityFrames = 0;
+    int32_t mFillLevel = 0;
+    int32_t mTargetFillLevel = 0;
+    double mPhase = 0; // fractional read position within the first frame
+    double mSmoothedFillLevel = 0;
+    double mIntegral = 0;
+    double mRatio = 1;
+    bool mPrimed = false;
+
+    std::atomic<double> mStatsRatio{1};
+    std::atomic<int32_t> mStatsFillLevel{0};
+    std::atomic<int32_t> mStatsTargetFillLevel{0};
+    std::atomic<uint32_t> mUnderflows{0};
+    std::atomic<uint32_t> mOverflows{0};
+
+    void dropOldest(int32_t numFrames);
+    void updateRatio(int32_t numFrames);
+};
+
+#endif //LDSP_DRIFT_COMPENSATOR_H
@@ -14,10 +14,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include "common/OboeDebug.h"
 #include "FullDuplexStream.h"
 
 oboe::ResultWithValue<int32_t>  FullDuplexStream::readInput(int32_t numFrames) {
+    if (mFloatPath) {
+        return getInputStream()->read(mInputBuffer.get(), numFrames, 0 /* timeout */);
+    }
+
     oboe::ResultWithValue<int32_t> result = getInputStream()->read(
             mInputConverter->getInputBuffer(),
             numFrames,
@@ -35,10 +40,8 @@ oboe::DataCallbackResult FullDuplexStream::onAudioReady(
         int numFrames) {
     oboe::DataCallbackResult callbackResult = oboe::DataCallbackResult::Continue;
     int32_t actualFramesRead = 0;
-
-    // Silence the output.
-    int32_t numBytes = numFrames * outputStream->getBytesPerFrame();
-    memset(audioData, 0 /* value */, numBytes);
+    //VIC output is silenced only if nothing gets rendered into it, i.e., during warm-up or on errors
+    bool outputWritten = false;
 
     if (mCountCallbacksToDrain > 0) {
         // Drain the input.
@@ -79,6 +82,14 @@ oboe::DataCallbackResult FullDuplexStream::onAudioReady(
                 }
             }
         }
+    } else if (mDriftCompensation) {
+        //VIC read whatever is available, then pull exactly numFrames out of the fifo
+        callbackResult = readInputIntoCompensator(numFrames);
+        if (callbackResult == oboe::DataCallbackResult::Continue) {
+            mDriftCompensator.process(mCompensatedInput.get(), numFrames);
+            callbackResult = renderOutput(mCompensatedInput.get(), numFrames, audioData, numFrames);
+            outputWritten = true;
+        }
     } else {
         int32_t framesRead = 0;
         oboe::ResultWithValue<int32_t> resultAvailable = getInputStream()->getAvailableFrames();
@@ -100,15 +111,17 @@ oboe::DataCallbackResult FullDuplexStream::onAudioReady(
         }
 
         if (callbackResult == oboe::DataCallbackResult::Continue) {
-            callbackResult = onBothStreamsReady(
-                    (float *) mInputConverter->getOutputBuffer(),
-                    framesRead,
-                    (float *) mOutputConverter->getInputBuffer(), numFrames);
-            mOutputConverter->convertFromInternalInput( audioData,
-                                       numFrames * getOutputStream()->getChannelCount());
+            callbackResult = renderOutput(getInputData(), framesRead, audioData, numFrames);
+            outputWritten = true;
         }
     }
 
+    if (!outputWritten) {
+        // Silence the output.
+        int32_t numBytes = numFrames * outputStream->getBytesPerFrame();
+        memset(audioData, 0 /* value */, numBytes);
+    }
+
     if (callbackResult == oboe::DataCallbackResult::Stop) {
         getInputStream()->requestStop();
     }
@@ -116,20 +129,92 @@ oboe::DataCallbackResult FullDuplexStream::onAudioReady(
     return callbackResult;
 }
 
+oboe::DataCallbackResult FullDuplexStream::readInputIntoCompensator(int32_t maxFramesPerRead) {
+    int32_t channelCount = getInputStream()->getChannelCount();
+    while (mDriftCompensator.getWritableFrames() > 0) {
+        int32_t framesToRead = std::min(mDriftCompensator.getWritableFrames(), maxFramesPerRead);
+        int32_t framesRead = 0;
+        if (mFloatPath) {
+            // straight into the fifo
+            oboe::ResultWithValue<int32_t> resultRead = getInputStream()->read(
+                    mDriftCompensator.getWriteBuffer(), framesToRead, 0 /* timeout */);
+            if (!resultRead) {
+                LOGE("%s() read() returned %s\n", __func__, convertToText(resultRead.error()));
+                return oboe::DataCallbackResult::Stop;
+            }
+            framesRead = resultRead.value();
+        } else {
+            oboe::ResultWithValue<int32_t> resultRead = readInput(framesToRead);
+            if (!resultRead) {
+                LOGE("%s() read() returned %s\n", __func__, convertToText(resultRead.error()));
+                return oboe::DataCallbackResult::Stop;
+            }
+            framesRead = resultRead.value();
+            memcpy(mDriftCompensator.getWriteBuffer(), getInputData(), framesRead * channelCount * sizeof(float));
+        }
+        if (framesRead == 0) {
+            break;
+        }
+        mDriftCompensator.advanceWrite(framesRead);
+    }
+    return oboe::DataCallbackResult::Continue;
+}
+
+oboe::DataCallbackResult FullDuplexStream::renderOutput(float *inputData, int32_t numInputFrames,
+                                                        void *audioData, int numFrames) {
+    oboe::DataCallbackResult callbackResult;
+    if (mFloatPath) {
+        callbackResult = onBothStreamsReady(
+                inputData,
+                numInputFrames,
+                (float *) audioData, numFrames);
+    } else {
+        callbackResult = onBothStreamsReady(
+                inputData,
+                numInputFrames,
+                (float *) mOutputConverter->getInputBuffer(), numFrames);
+        mOutputConverter->convertFromInternalInput( audioData,
+                                   numFrames * getOutputStream()->getChannelCount());
+    }
+    return callbackResult;
+}
+
 oboe::Result FullDuplexStream::start() {
     mCountCallbacksToDrain = kNumCallbacksToDrain;
     mCountInputBurstsCushion = mNumInputBurstsCushion;
     mCountCallbacksToDiscard = kNumCallbacksToDiscard;
 
     // Determine maximum size that could possibly be called.
-    int32_t bufferSize = getOutputStream()->getBufferCapacityInFrames()
-            * getOutputStream()->getChannelCount();
-    mInputConverter = std::make_unique<FormatConverterBox>(bufferSize,
-            getInputStream()->getFormat(),
-            oboe::AudioFormat::Float);
-    mOutputConverter = std::make_unique<FormatConverterBox>(bufferSize,
-            oboe::AudioFormat::Float,
-            getOutputStream()->getFormat());
+    //VIC input and output may have different channel counts, so each converter is sized on its own stream
+    int32_t maxFrames = getOutputStream()->getBufferCapacityInFrames();
+    mFloatPath = getInputStream()->getFormat() == oboe::AudioFormat::Float
+            && getOutputStream()->getFormat() == oboe::AudioFormat::Float;
+    if (mFloatPath) {
+        mInputBuffer = std::make_unique<float[]>(maxFrames * getInputStream()->getChannelCount());
+        mInputConverter.reset();
+        mOutputConverter.reset();
+    } else {
+        mInputBuffer.reset();
+        mInputConverter = std::make_unique<FormatConverterBox>(maxFrames * getInputStream()->getChannelCount(),
+                getInputStream()->getFormat(),
+                oboe::AudioFormat::Float);
+        mOutputConverter = std::make_unique<FormatConverterBox>(maxFrames * getOutputStream()->getChannelCount(),
+                oboe::AudioFormat::Float,
+                getOutputStream()->getFormat());
+    }
+
+    if (mDriftCompensation) {
+        //VIC target is one callback plus a cushion that absorbs the input's burstiness
+        int32_t inputChannels = getInputStream()->getChannelCount();
+        int32_t framesPerCallback = getOutputStream()->getFramesPerCallback();
+        if (framesPerCallback <= 0) {
+            framesPerCallback = getOutputStream()->getFramesPerBurst();
+        }
+        int32_t cushion = (mDriftCushionFrames > 0) ? mDriftCushionFrames : getInputStream()->getFramesPerBurst();
+        int32_t target = framesPerCallback + cushion;
+        mDriftCompensator.reset(inputChannels, std::max(4 * target, 2 * maxFrames), target);
+        mCompensatedInput = std::make_unique<float[]>(maxFrames * inputChannels);
+    }
 
     oboe::Result result = getInputStream()->requestStart();
     if (result != oboe::Result::OK) {
@@ -27,6 +27,7 @@
 #include "oboe/Oboe.h"
 
 #include "FormatConverterBox.h"
+#include "DriftCompensator.h"
 
 class FullDuplexStream : public oboe::AudioStreamCallback {
 public:
@@ -92,6 +93,28 @@ public:
         return mMinimumFramesBeforeRead;
     }
 
+    /**
+     * VIC must be set before start()
+     * input goes through a fifo that is resampled to keep input and output clocks in sync,
+     * so onBothStreamsReady() always receives as many input frames as output frames
+     *
+     * @param enabled
+     * @param cushionFrames frames kept in the fifo on top of one callback, 0 for one input burst
+     */
+    void setDriftCompensation(bool enabled, int32_t cushionFrames = 0) {
+        mDriftCompensation = enabled;
+        mDriftCushionFrames = cushionFrames;
+    }
+
+    bool getDriftCompensation() const {
+        return mDriftCompensation;
+    }
+
+    // can be polled from any thread
+    void getDriftStats(DriftCompensatorStats &stats) const {
+        mDriftCompensator.getStats(stats);
+    }
+
 private:
 
     // TODO add getters and setters
@@ -117,6 +140,24 @@ private:
 
     std::unique_ptr<FormatConverterBox> mInputConverter;
     std::unique_ptr<FormatConverterBox> mOutputConverter;
+
+    //VIC when both streams are Float, no conversion is needed:
+    // input is read straight into mInputBuffer and output is rendered straight into the device's buffer
+    bool mFloatPath = false;
+    std::unique_ptr<float[]> mInputBuffer;
+
+    float *getInputData() {
+        return mFloatPath ? mInputBuffer.get() : (float *) mInputConverter->getOutputBuffer();
+    }
+
+    bool mDriftCompensation = false;
+    int32_t mDriftCushionFrames = 0;
+    DriftCompensator mDriftCompensator;
+    std::unique_ptr<float[]> mCompensatedInput;
+
+    oboe::DataCallbackResult readInputIntoCompensator(int32_t maxFramesPerRead);
+    oboe::DataCallbackResult renderOutput(float *inputData, int32_t numInputFrames,
+                                          void *audioData, int numFrames);
 };
 
 
@@ -48,6 +48,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #else
 #include "seasocks/win32/winsock_includes.h"
 #include <sys/stat.h>
@@ -269,7 +270,7 @@ void Connection::close() {
 }
 
 void Connection::closeWhenEmpty() {
-    if (_outBuf.empty()) {
+    if (outputBufferSize() == 0) {
         closeInternal();
     } else {
         _closeOnEmpty = true;
@@ -321,6 +322,43 @@ ssize_t Connection::safeSend(const void* data, size_t size) {
     auto sendResult = ::send(_fd, static_cast<const char*>(data),
                              static_cast<int>(size), MSG_NOSIGNAL);
 #endif
+    return handleSendResult(sendResult);
+}
+
+// Sends as much of the queued segments and _outBuf as the socket takes, in one call.
+ssize_t Connection::safeSendQueued() {
+    if (_fd == -1 || _hadSendError || _shutdown) {
+        return -1;
+    }
+#ifndef _WIN32
+    constexpr int MaxIovecs = 64;
+    iovec iov[MaxIovecs];
+    int count = 0;
+    for (const auto& segment : _outQueue) {
+        if (count == MaxIovecs) {
+            break;
+        }
+        iov[count].iov_base = const_cast<uint8_t*>(segment.data->data() + segment.offset);
+        iov[count].iov_len = segment.data->size() - segment.offset;
+        ++count;
+    }
+    if (count < MaxIovecs && !_outBuf.empty()) {
+        iov[count].iov_base = &_outBuf[0];
+        iov[count].iov_len = _outBuf.size();
+        ++count;
+    }
+    // Like writev(), but with MSG_NOSIGNAL.
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return handleSendResult(::sendmsg(_fd, &msg, MSG_NOSIGNAL));
+#else
+    const auto& segment = _outQueue.front();
+    return safeSend(segment.data->data() + segment.offset, segment.data->size() - segment.offset);
+#endif
+}
+
+ssize_t Connection::handleSendResult(ssize_t sendResult) {
     if (sendResult == -1) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             // Treat this as if zero bytes were written.
@@ -340,7 +378,7 @@ bool Connection::write(const void* data, size_t size, bool flushIt) {
     }
     if (size) {
         ssize_t bytesSent = 0;
-        if (_outBuf.empty() && flushIt) {
+        if (outputBufferSize() == 0 && flushIt) {
             // Attempt fast path, send directly.
             bytesSent = safeSend(data, size);
             if (bytesSent == static_cast<int>(size)) {
@@ -354,9 +392,9 @@ bool Connection::write(const void* data, size_t size, bool flushIt) {
         size_t bytesToBuffer = size - bytesSent;
         size_t endOfBuffer = _outBuf.size();
         size_t newBufferSize = endOfBuffer + bytesToBuffer;
-        if (newBufferSize >= _server.clientBufferSize()) {
+        if (_outQueueSize + newBufferSize >= _server.clientBufferSize()) {
             LS_WARNING(_logger, "Closing connection: buffer size too large ("
-                                    << newBufferSize << " >= " << _server.clientBufferSize() << ")");
+                                    << _outQueueSize + newBufferSize << " >= " << _server.clientBufferSize() << ")");
             closeInternal();
             return false;
         }
@@ -369,6 +407,57 @@ bool Connection::write(const void* data, size_t size, bool flushIt) {
     return true;
 }
 
+bool Connection::writeShared(std::shared_ptr<const std::vector<uint8_t>> data) {
+    if (closed() || _closeOnEmpty) {
+        return false;
+    }
+    size_t size = data->size();
+    size_t bytesSent = 0;
+    if (outputBufferSize() == 0) {
+        // Attempt fast path, send directly.
+        auto sendResult = safeSend(data->data(), size);
+        if (sendResult == -1) {
+            return false;
+        }
+        bytesSent = sendResult;
+        if (bytesSent == size) {
+            return true;
+        }
+    }
+    size_t newBufferSize = outputBufferSize() + size - bytesSent;
+    if (newBufferSize >= _server.clientBufferSize()) {
+        LS_WARNING(_logger, "Closing connection: buffer size too large ("
+                                << newBufferSize << " >= " << _server.clientBufferSize() << ")");
+        closeInternal();
+        return false;
+    }
+    if (!_outBuf.empty()) {
+        // Whatever was written before goes out first.
+        _outQueueSize += _outBuf.size();
+        _outQueue.push_back({std::make_shared<const std::vector<uint8_t>>(std::move(_outBuf)), 0});
+        _outBuf.clear();
+    }
+    _outQueueSize += size - bytesSent;
+    _outQueue.push_back({std::move(data), bytesSent});
+    return flush();
+}
+
+void Connection::consumeOutput(size_t size) {
+    while (size > 0 && !_outQueue.empty()) {
+        auto& segment = _outQueue.front();
+        size_t remaining = segment.data->size() - segment.offset;
+        if (size < remaining) {
+            segment.offset += size;
+            _outQueueSize -= size;
+            return;
+        }
+        size -= remaining;
+        _outQueueSize -= remaining;
+        _outQueue.pop_front();
+    }
+    _outBuf.erase(_outBuf.begin(), _outBuf.begin() + size);
+}
+
 bool Connection::bufferLine(const char* line) {
     static const char crlf[] = {'\r', '\n'};
     if (!write(line, strlen(line), false))
@@ -414,26 +503,26 @@ void Connection::handleDataReadyForWrite() {
 }
 
 bool Connection::flush() {
-    if (_outBuf.empty()) {
+    if (outputBufferSize() == 0) {
         return true;
     }
-    auto numSent = safeSend(&_outBuf[0], _outBuf.size());
+    auto numSent = _outQueue.empty() ? safeSend(&_outBuf[0], _outBuf.size()) : safeSendQueued();
     if (numSent == -1) {
         return false;
     }
-    _outBuf.erase(_outBuf.begin(), _outBuf.begin() + numSent);
-    if (!_outBuf.empty() && !_registeredForWriteEvents) {
+    consumeOutput(numSent);
+    if (outputBufferSize() != 0 && !_registeredForWriteEvents) {
         if (!_server.subscribeToWriteEvents(this)) {
             return false;
         }
         _registeredForWriteEvents = true;
-    } else if (_outBuf.empty() && _registeredForWriteEvents) {
+    } else if (outputBufferSize() == 0 && _registeredForWriteEvents) {
         if (!_server.unsubscribeFromWriteEvents(this)) {
             return false;
         }
         _registeredForWriteEvents = false;
     }
-    if (_outBuf.empty() && !closed() && _closeOnEmpty) {
+    if (outputBufferSize() == 0 && !closed() && _closeOnEmpty) {
         LS_DEBUG(_logger, "Ready for close, now empty");
         closeInternal();
     }
@@ -614,6 +703,79 @@ void Connection::send(const uint8_t* webSocketResponse, size_t length) {
     sendHybi(static_cast<uint8_t>(HybiPacketDecoder::Opcode::Binary), webSocketResponse, length);
 }
 
+void Connection::send(const std::shared_ptr<const WebSocket::Frame>& frame) {
+    _server.checkThread();
+    if (_shutdown) {
+        if (_shutdownByUser) {
+            LS_ERROR(_logger, "Server wrote to connection after closing it");
+        }
+        return;
+    }
+    const auto opcode = frame->isBinary() ? HybiPacketDecoder::Opcode::Binary : HybiPacketDecoder::Opcode::Text;
+    if (_state == State::HANDLING_HIXIE_WEBSOCKET) {
+        if (frame->isBinary()) {
+            LS_ERROR(_logger, "Hixie does not support binary");
+            return;
+        }
+        uint8_t zero = 0;
+        if (!write(&zero, 1, false))
+            return;
+        if (!write(frame->payload(), frame->payloadSize(), false))
+            return;
+        uint8_t effeff = 0xff;
+        write(&effeff, 1, true);
+        return;
+    }
+    if (_perMessageDeflate) {
+        // Compressed per connection, the shared frame cannot be used as is.
+        sendHybi(static_cast<uint8_t>(opcode), frame->payload(), frame->payloadSize());
+        return;
+    }
+    // Shares the frame's ownership, no copy.
+    writeShared(std::shared_ptr<const std::vector<uint8_t>>(frame, &frame->bytes()));
+}
+
+namespace {
+
+// The length part of a Hybi header [server frames are not masked], returns its size.
+size_t encodeHybiLength(size_t messageLength, uint8_t* out) {
+    if (messageLength < 126) {
+        out[0] = static_cast<uint8_t>(messageLength);
+        return 1;
+    } else if (messageLength < 65536) {
+        out[0] = 126;
+        // htons in Windows takes a u_short
+        const auto lengthBytes = htons(static_cast<uint16_t>(messageLength));
+        memcpy(out + 1, &lengthBytes, 2);
+        return 3;
+    }
+    out[0] = 127;
+    const uint64_t lengthBytes = __swap64(messageLength); //VIC it was __bswap_64
+    memcpy(out + 1, &lengthBytes, 8);
+    return 9;
+}
+
+}
+
+WebSocket::Frame::Frame(bool binary, const uint8_t* data, size_t length)
+        : _binary(binary) {
+    const auto opcode = binary ? HybiPacketDecoder::Opcode::Binary : HybiPacketDecoder::Opcode::Text;
+    uint8_t header[10];
+    header[0] = 0x80 | static_cast<uint8_t>(opcode);
+    _headerSize = 1 + encodeHybiLength(length, header + 1);
+    _bytes.reserve(_headerSize + length);
+    _bytes.insert(_bytes.end(), header, header + _headerSize);
+    _bytes.insert(_bytes.end(), data, data + length);
+}
+
+std::shared_ptr<const WebSocket::Frame> WebSocket::Frame::text(const char* data) {
+    return std::shared_ptr<const Frame>(new Frame(false, reinterpret_cast<const uint8_t*>(data), strlen(data)));
+}
+
+std::shared_ptr<const WebSocket::Frame> WebSocket::Frame::binary(const uint8_t* data, size_t length) {
+    return std::shared_ptr<const Frame>(new Frame(true, data, length));
+}
+
 void Connection::sendHybi(uint8_t opcode, const uint8_t* webSocketResponse, size_t messageLength) {
     uint8_t firstByte = 0x80 | opcode;
     if (_perMessageDeflate)
@@ -634,26 +796,10 @@ void Connection::sendHybi(uint8_t opcode, const uint8_t* webSocketResponse, size
 }
 
 void Connection::sendHybiData(const uint8_t* webSocketResponse, size_t messageLength) {
-    if (messageLength < 126) {
-        const auto nextByte = static_cast<uint8_t>(messageLength); // No MASK bit set.
-        if (!write(&nextByte, 1, false))
-            return;
-    } else if (messageLength < 65536) {
-        const uint8_t nextByte = 126; // No MASK bit set.
-        if (!write(&nextByte, 1, false))
-            return;
-        // htons in Windows takes a u_short
-        const auto lengthBytes = htons(static_cast<uint16_t>(messageLength));
-        if (!write(&lengthBytes, 2, false))
-            return;
-    } else {
-        const uint8_t nextByte = 127; // No MASK bit set.
-        if (!write(&nextByte, 1, false))
-            return;
-        const uint64_t lengthBytes = __swap64(messageLength); //VIC it was __bswap_64
-        if (!write(&lengthBytes, 8, false))
-            return;
-    }
+    uint8_t lengthBytes[9];
+    const auto lengthSize = encodeHybiLength(messageLength, lengthBytes); // No MASK bit set.
+    if (!write(lengthBytes, lengthSize, false))
+        return;
     write(webSocketResponse, messageLength, true);
 }
 
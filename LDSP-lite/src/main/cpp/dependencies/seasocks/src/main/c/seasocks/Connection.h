@@ -41,6 +41,7 @@
 #endif
 
 #include <cinttypes>
+#include <deque>
 #include <list>
 #include <memory>
 #include <string>
@@ -74,6 +75,7 @@ public:
     // From WebSocket.
     virtual void send(const char* webSocketResponse) override;
     virtual void send(const uint8_t* webSocketResponse, size_t length) override;
+    virtual void send(const std::shared_ptr<const WebSocket::Frame>& frame) override;
     virtual void close() override;
 
     // From Request.
@@ -101,7 +103,7 @@ public:
         return _inBuf.size();
     }
     size_t outputBufferSize() const {
-        return _outBuf.size();
+        return _outQueueSize + _outBuf.size();
     }
 
     size_t bytesReceived() const {
@@ -144,6 +146,9 @@ private:
     bool bufferLine(const char* line);
     bool bufferLine(const std::string& line);
     bool flush();
+    // Queues shared bytes by reference, ahead of anything written afterwards.
+    bool writeShared(std::shared_ptr<const std::vector<uint8_t>> data);
+    void consumeOutput(size_t size);
 
     bool handleHybiHandshake(int webSocketVersion, const std::string& webSocketKey);
 
@@ -188,6 +193,8 @@ private:
     bool sendStaticData();
 
     ssize_t safeSend(const void* data, size_t size);
+    ssize_t safeSendQueued();
+    ssize_t handleSendResult(ssize_t sendResult);
 
     void bufferResponseAndCommonHeaders(ResponseCode code);
 
@@ -205,6 +212,14 @@ private:
     size_t _bytesSent;
     size_t _bytesReceived;
     std::vector<uint8_t> _inBuf;
+    // Pending output: shared segments [with how much of the first one was
+    // already sent], then _outBuf, which is owned and where write() appends.
+    struct OutSegment {
+        std::shared_ptr<const std::vector<uint8_t>> data;
+        size_t offset;
+    };
+    std::deque<OutSegment> _outQueue;
+    size_t _outQueueSize = 0; // bytes still to send in _outQueue
     std::vector<uint8_t> _outBuf;
     std::shared_ptr<WebSocket::Handler> _webSocketHandler;
     bool _shutdownByUser;
@@ -27,6 +27,7 @@
 
 #include "seasocks/Request.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 #ifdef WIN32
@@ -46,6 +47,37 @@ namespace seasocks {
 
 class WebSocket : public Request {
 public:
+    /**
+     * A message framed once, that can be sent as is to any number of
+     * WebSockets without copying it into each of their output buffers.
+     * Immutable and shared, see WebSocket::broadcast().
+     */
+    class Frame {
+    public:
+        static std::shared_ptr<const Frame> text(const char* data);
+        static std::shared_ptr<const Frame> binary(const uint8_t* data, size_t length);
+
+        bool isBinary() const {
+            return _binary;
+        }
+        // Hybi header followed by the payload, as it goes on the wire.
+        const std::vector<uint8_t>& bytes() const {
+            return _bytes;
+        }
+        const uint8_t* payload() const {
+            return _bytes.data() + _headerSize;
+        }
+        size_t payloadSize() const {
+            return _bytes.size() - _headerSize;
+        }
+
+    private:
+        Frame(bool binary, const uint8_t* data, size_t length);
+        bool _binary;
+        size_t _headerSize;
+        std::vector<uint8_t> _bytes;
+    };
+
     /**
      * Send the given text data. Must be called on the seasocks thread.
      * See Server::execute for how to run work on the seasocks
@@ -66,6 +98,37 @@ public:
      * thread externally.
      */
     virtual void send(const uint8_t* data, size_t length) = 0;
+    /**
+     * Send a pre-framed message, which is queued by reference. Must be called
+     * on the seasocks thread. Connections that cannot send the frame as is
+     * (e.g. with per-message deflate) fall back to framing the payload themselves.
+     */
+    virtual void send(const std::shared_ptr<const Frame>& frame) = 0;
+
+    /**
+     * Send the same text or binary data to all the given WebSockets, framing
+     * it only once. Must be called on the seasocks thread.
+     */
+    template <typename WebSockets>
+    static void broadcast(const WebSockets& sockets, const char* data) {
+        if (sockets.size() == 1) {
+            (*sockets.begin())->send(data); // nothing to share
+        } else if (!sockets.empty()) {
+            auto frame = Frame::text(data);
+            for (auto socket : sockets)
+                socket->send(frame);
+        }
+    }
+    template <typename WebSockets>
+    static void broadcast(const WebSockets& sockets, const uint8_t* data, size_t length) {
+        if (sockets.size() == 1) {
+            (*sockets.begin())->send(data, length);
+        } else if (!sockets.empty()) {
+            auto frame = Frame::binary(data, length);
+            for (auto socket : sockets)
+                socket->send(frame);
+        }
+    }
     /**
      * Close the socket. It's invalid to access the socket after
      * calling close(). The Handler::onDisconnect() call may occur
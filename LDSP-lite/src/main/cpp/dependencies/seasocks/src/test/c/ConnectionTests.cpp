@@ -33,9 +33,25 @@
 #include <sstream>
 #include <cstring>
 #include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace seasocks;
 
+namespace {
+
+void appendAvailable(int fd, std::vector<uint8_t>& out) {
+    uint8_t buf[4096];
+    ssize_t numRead;
+    while ((numRead = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        out.insert(out.end(), buf, buf + numRead);
+}
+
+}
+
 class TestHandler : public WebSocket::Handler {
 public:
     int _stage;
@@ -85,3 +101,85 @@ TEST_CASE("Connection tests", "[ConnectionTests]") {
         connection.handleNewData();
     }
 }
+
+TEST_CASE("Shared frame tests", "[ConnectionTests]") {
+    SECTION("should encode the header once, for all payload lengths") {
+        auto small = WebSocket::Frame::text("hello");
+        CHECK_FALSE(small->isBinary());
+        REQUIRE(small->bytes().size() == 7);
+        CHECK(small->bytes()[0] == 0x81);
+        CHECK(small->bytes()[1] == 5);
+        CHECK(memcmp(small->payload(), "hello", 5) == 0);
+
+        std::vector<uint8_t> medium(300, 0x55);
+        auto mediumFrame = WebSocket::Frame::binary(medium.data(), medium.size());
+        CHECK(mediumFrame->isBinary());
+        REQUIRE(mediumFrame->bytes().size() == 4 + 300);
+        CHECK(mediumFrame->bytes()[0] == 0x82);
+        CHECK(mediumFrame->bytes()[1] == 126);
+        CHECK(mediumFrame->bytes()[2] == 0x01);
+        CHECK(mediumFrame->bytes()[3] == 0x2c);
+        CHECK(mediumFrame->payloadSize() == 300);
+
+        std::vector<uint8_t> large(70000, 0xaa);
+        auto largeFrame = WebSocket::Frame::binary(large.data(), large.size());
+        const uint8_t largeHeader[] = {0x82, 127, 0, 0, 0, 0, 0, 0x01, 0x11, 0x70};
+        REQUIRE(largeFrame->bytes().size() == sizeof(largeHeader) + 70000);
+        CHECK(memcmp(largeFrame->bytes().data(), largeHeader, sizeof(largeHeader)) == 0);
+        CHECK(largeFrame->payloadSize() == 70000);
+    }
+    SECTION("should queue a shared frame on several connections, in order with other writes") {
+        sockaddr_in addr;
+        addr.sin_family = AF_INET;
+        addr.sin_port = 0x1234;
+        addr.sin_addr.s_addr = 0x01020304;
+        auto logger = std::make_shared<IgnoringLogger>();
+        MockServerImpl mockServer;
+
+        // small, non-blocking send buffers, so that the frame has to be queued and flushed in several goes
+        int firstPair[2], secondPair[2];
+        REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, firstPair) == 0);
+        REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, secondPair) == 0);
+        for (int fd : {firstPair[0], secondPair[0]}) {
+            int size = 4096;
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+            ::fcntl(fd, F_SETFL, O_NONBLOCK);
+        }
+
+        std::vector<uint8_t> payload(100000);
+        for (size_t i = 0; i < payload.size(); ++i)
+            payload[i] = static_cast<uint8_t>(i * 7);
+        auto frame = WebSocket::Frame::binary(payload.data(), payload.size());
+
+        std::vector<uint8_t> firstReceived, secondReceived;
+        {
+            Connection first(logger, mockServer, firstPair[0], addr);
+            Connection second(logger, mockServer, secondPair[0], addr);
+            first.send(frame);
+            second.send(frame);
+            first.send("after");
+            first.send(frame); // behind the bytes buffered for "after"
+            CHECK(first.outputBufferSize() > 0);
+
+            for (int i = 0; i < 10000 && (first.outputBufferSize() > 0 || second.outputBufferSize() > 0); ++i) {
+                appendAvailable(firstPair[1], firstReceived);
+                appendAvailable(secondPair[1], secondReceived);
+                first.handleDataReadyForWrite();
+                second.handleDataReadyForWrite();
+            }
+            CHECK(first.outputBufferSize() == 0);
+            CHECK(second.outputBufferSize() == 0);
+            appendAvailable(firstPair[1], firstReceived);
+            appendAvailable(secondPair[1], secondReceived);
+        }
+        ::close(firstPair[1]);
+        ::close(secondPair[1]);
+
+        std::vector<uint8_t> firstExpected = frame->bytes();
+        const uint8_t after[] = {0x81, 5, 'a', 'f', 't', 'e', 'r'};
+        firstExpected.insert(firstExpected.end(), after, after + sizeof(after));
+        firstExpected.insert(firstExpected.end(), frame->bytes().begin(), frame->bytes().end());
+        CHECK(firstReceived == firstExpected);
+        CHECK(secondReceived == frame->bytes());
+    }
+}
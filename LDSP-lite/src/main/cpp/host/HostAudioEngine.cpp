@@ -0,0 +1,249 @@
+#include "HostAudioEngine.h"
+#include "LDSP_log.h"
+#include "thread_utils.h"
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+// defined in host's CMakeLists.txt
+#ifdef PROJECT_NAME
+#define PRJ_NAME PROJECT_NAME
+#else
+#define PRJ_NAME ""
+#endif
+
+using std::chrono::steady_clock;
+
+namespace ldsplite {
+
+HostAudioEngine::HostAudioEngine() : AudioEngine(nullptr) {
+  _captureOff = false;
+  _verbose = false;
+  _inputPos = 0;
+  _loopInput = true;
+  _offlineFrames = 0;
+  _offlineRenderTimeS = 0;
+  resetStats();
+}
+
+HostAudioEngine::~HostAudioEngine() {
+  stop();
+}
+
+void HostAudioEngine::init(LDSPinitSettings *settings, unsigned int inChannels, unsigned int outChannels) {
+  _settings = *settings;
+  _captureOff = settings->captureOff;
+  _verbose = settings->verbose;
+
+  _inBuff.assign(settings->periodSize * inChannels, 0);
+  _outBuff.assign(settings->periodSize * outChannels, 0);
+
+  intContext.projectName = PRJ_NAME;
+  intContext.audioSampleRate = settings->samplerate;
+  intContext.audioInChannels = inChannels;
+  intContext.audioOutChannels = outChannels;
+  intContext.audioFrames = settings->periodSize;
+  setRenderBlockSize(settings->renderBlockSize);
+
+  // same as the unsupported sensors/channels in initSensorBuffers()
+  _sensorBuffer.assign(chn_sens_count, 0);
+  _sensorsSupported = std::make_unique<bool[]>(chn_sens_count);
+  _sensorsDetails = std::make_unique<string[]>(chn_sens_count);
+  for(int chn=0; chn<chn_sens_count; chn++) {
+    _sensorsSupported[chn] = false;
+    _sensorsDetails[chn] = "Not supported";
+  }
+  intContext.sensors = _sensorBuffer.data();
+  intContext.controlSampleRate = (int)(settings->samplerate / settings->periodSize);
+  intContext.sensorChannels = chn_sens_count;
+  intContext.sensorsSupported = _sensorsSupported.get();
+  intContext.sensorsDetails = _sensorsDetails.get();
+
+  // no touch screen, ctrlInputs stay at their idle values
+  _ctrlInputs.setupContext(&intContext);
+  setUpdateCtrlInBufferCallback([this]() {
+    _ctrlInputs.updateBuffer();
+  });
+}
+
+void HostAudioEngine::setInput(const std::vector<std::vector<float>>& input) {
+  _input = input;
+  _inputPos = 0;
+}
+
+bool HostAudioEngine::start() {
+  if(!callSetup(_settings.periodSize)) {
+    LDSP_log("Couldn't set up project %s", intContext.projectName.c_str());
+    return false;
+  }
+
+  resetStats();
+  _loopInput = true;
+
+  _shouldStop = false;
+  _isRunning = true;
+  pthread_create(&audio_thread, NULL, audio_func_static, this);
+  return true;
+}
+
+void HostAudioEngine::stop() {
+  if(!_isRunning)
+    return;
+
+  _shouldStop = true;
+  pthread_join(audio_thread, NULL);
+  _isRunning = false;
+
+  callCleanup();
+}
+
+bool HostAudioEngine::renderOffline(const std::vector<std::vector<float>>& input, std::vector<std::vector<float>>& output) {
+  if(_isRunning) {
+    LDSP_log("Cannot render offline while the engine is running");
+    return false;
+  }
+  if(input.empty() || input[0].empty()) {
+    LDSP_log("Nothing to render offline");
+    return false;
+  }
+
+  setInput(input);
+  _loopInput = false;
+
+  unsigned int frames = input[0].size();
+  unsigned int outChannels = intContext.audioOutChannels;
+  unsigned int periodSize = _settings.periodSize;
+  output.assign(outChannels, std::vector<float>(frames, 0));
+
+  if(!callSetup(_settings.periodSize)) {
+    LDSP_log("Couldn't set up project %s", intContext.projectName.c_str());
+    return false;
+  }
+
+  resetStats();
+  auto offlineStart = steady_clock::now();
+
+  // the render block fifo delays the output, we render that much longer and skip it, so that output stays aligned with input
+  unsigned int latency = getRenderBlockLatency();
+
+  // no clock and no sleeping, the next block starts as soon as render() returns
+  for(unsigned int start=0; start<frames+latency; start+=periodSize) {
+    renderNextPeriod();
+
+    // the last block is zero-padded on the input and trimmed on the output
+    for(unsigned int n=0; n<periodSize; n++) {
+      if(start + n < latency)
+        continue;
+      unsigned int outFrame = start + n - latency;
+      if(outFrame >= frames)
+        break;
+      for(unsigned int chn=0; chn<outChannels; chn++)
+        output[chn][outFrame] = _outBuff[n*outChannels + chn];
+    }
+  }
+
+  _offlineRenderTimeS = std::chrono::duration<double>(steady_clock::now() - offlineStart).count();
+  _offlineFrames = frames;
+
+  callCleanup();
+  return true;
+}
+
+double HostAudioEngine::getOfflineSpeed() const {
+  if(_offlineRenderTimeS <= 0)
+    return 0;
+  return (_offlineFrames / _settings.samplerate) / _offlineRenderTimeS;
+}
+
+double HostAudioEngine::getMeanRenderTimeUs() const {
+  if(_callbacks == 0)
+    return 0;
+  return _totalRenderTimeUs / _callbacks;
+}
+
+double HostAudioEngine::getPeriodUs() const {
+  return 1000000.0 * _settings.periodSize / _settings.samplerate;
+}
+
+//------------------------------------------------------------------------
+
+void HostAudioEngine::resetStats() {
+  _callbacks = 0;
+  _totalRenderTimeUs = 0;
+  _maxRenderTimeUs = 0;
+  _deadlineMisses = 0;
+}
+
+void HostAudioEngine::fillInput() {
+  unsigned int inChannels = intContext.audioInChannels;
+  if(_captureOff || _input.empty() || _input[0].empty()) {
+    std::memset(_inBuff.data(), 0, _inBuff.size() * sizeof(float));
+    return;
+  }
+
+  // interleave, files with less channels than the engine are wrapped around
+  unsigned int fileFrames = _input[0].size();
+  // periods, not intContext.audioFrames, which is the render block size if one is set
+  unsigned int periodSize = _settings.periodSize;
+  for(unsigned int n=0; n<periodSize; n++) {
+    if(_inputPos >= fileFrames) {
+      if(!_loopInput) {
+        // past the end of the input, pad with zeros
+        std::memset(&_inBuff[n*inChannels], 0, (periodSize-n) * inChannels * sizeof(float));
+        return;
+      }
+      _inputPos = 0;
+    }
+    for(unsigned int chn=0; chn<inChannels; chn++)
+      _inBuff[n*inChannels + chn] = _input[chn % _input.size()][_inputPos];
+    _inputPos++;
+  }
+}
+
+// fills the input, calls render() and keeps track of how long it took
+steady_clock::time_point HostAudioEngine::renderNextPeriod() {
+  fillInput();
+
+  auto renderStart = steady_clock::now();
+  callRender(_settings.periodSize, _inBuff.data(), _outBuff.data());
+  auto renderEnd = steady_clock::now();
+
+  double renderTimeUs = std::chrono::duration<double, std::micro>(renderEnd - renderStart).count();
+  _totalRenderTimeUs += renderTimeUs;
+  if(renderTimeUs > _maxRenderTimeUs)
+    _maxRenderTimeUs = renderTimeUs;
+  _callbacks++;
+
+  return renderEnd;
+}
+
+void* HostAudioEngine::audio_func() {
+  auto period = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double, std::micro>(getPeriodUs()));
+  auto deadline = steady_clock::now();
+
+  while(!_shouldStop) {
+    auto renderEnd = renderNextPeriod();
+
+    // synthetic clock, one period per callback
+    // if render() took longer than that, we count it as a deadline miss and start again from now, like a device would after an xrun
+    deadline += period;
+    if(renderEnd > deadline) {
+      _deadlineMisses++;
+      deadline = renderEnd;
+    }
+    else
+      std::this_thread::sleep_until(deadline);
+  }
+  return (void *)0;
+}
+
+void* HostAudioEngine::audio_func_static(void* arg) {
+  HostAudioEngine* engine = static_cast<HostAudioEngine*>(arg);
+
+  // may fail without the right privileges, render() runs anyway
+  set_priority(LDSPprioOrder_audio, engine->_verbose);
+
+  return engine->audio_func();
+}
+
+}  // namespace ldsplite
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AudioEngine.h"
+#include "CtrlInputs.h"
+#include <pthread.h>
+#include <chrono>
+#include <vector>
+
+namespace ldsplite {
+
+// Audio engine for the headless Linux host build
+// it runs the same setup()/render()/cleanup() contract as OboeAudioEngine, but callRender() is driven by a synthetic clock
+// that wakes up once per period, so that render.cpp projects can be profiled and regression-tested without a phone
+class HostAudioEngine : public AudioEngine {
+ public:
+  HostAudioEngine();
+  ~HostAudioEngine();
+
+  void init(LDSPinitSettings *settings, unsigned int inChannels, unsigned int outChannels);
+  // one vector per channel, as returned by AudioFileUtilities::load(); it is looped for as long as the engine runs
+  // if not set, or if capture is off, render() receives silence
+  void setInput(const std::vector<std::vector<float>>& input);
+  bool start();
+  void stop();
+  bool isRunning() const { return _isRunning; }
+
+  // offline mode, alternative to start()/stop()
+  // renders the whole input once, in audioFrames-sized blocks and as fast as the CPU allows, on the calling thread
+  // output is resized to one vector per output channel, as long as the input
+  bool renderOffline(const std::vector<std::vector<float>>& input, std::vector<std::vector<float>>& output);
+  // wall-clock time spent rendering by the last offline run [file I/O excluded] and resulting speed compared to real-time
+  double getOfflineRenderTimeS() const { return _offlineRenderTimeS; }
+  double getOfflineSpeed() const;
+
+  // render() cost, updated by the audio thread and meant to be read once the engine is stopped
+  unsigned long getCallbacks() const { return _callbacks; }
+  double getMeanRenderTimeUs() const;
+  double getMaxRenderTimeUs() const { return _maxRenderTimeUs; }
+  unsigned long getDeadlineMisses() const { return _deadlineMisses; }
+  // deadline misses are the closest thing to xruns we have
+  int getXRunCount() override { return (int)_deadlineMisses; }
+  double getPeriodUs() const;
+
+ private:
+  LDSPinitSettings _settings;
+  bool _captureOff;
+  bool _verbose;
+  std::vector<float> _inBuff;
+  std::vector<float> _outBuff;
+  std::vector<std::vector<float>> _input;
+  unsigned int _inputPos;
+  bool _loopInput;
+
+  // sensors are not available on the host, buffers are allocated anyway to keep the context consistent
+  std::vector<float> _sensorBuffer;
+  std::unique_ptr<bool[]> _sensorsSupported;
+  std::unique_ptr<string[]> _sensorsDetails;
+  CtrlInputs _ctrlInputs;
+
+  unsigned long _callbacks;
+  double _totalRenderTimeUs;
+  double _maxRenderTimeUs;
+  unsigned long _deadlineMisses;
+  unsigned long _offlineFrames;
+  double _offlineRenderTimeS;
+
+  std::atomic<bool> _shouldStop{false};
+  std::atomic<bool> _isRunning{false};
+  pthread_t audio_thread;
+  void resetStats();
+  void fillInput();
+  std::chrono::steady_clock::time_point renderNextPeriod();
+  void* audio_func();
+  static void* audio_func_static(void* arg);
+};
+
+}  // namespace ldsplite
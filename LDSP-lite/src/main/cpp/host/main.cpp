@@ -0,0 +1,183 @@
+// Entry point of the headless Linux host build
+// it runs the current LDSP project on HostAudioEngine, then prints how much of each period render() used
+// in offline mode, it renders an input file to an output file as fast as possible and prints the speed compared to real-time
+
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "HostAudioEngine.h"
+#include "AudioFile.h"
+
+using namespace ldsplite;
+
+static std::atomic<bool> gShouldStop{false};
+
+static void interrupt_handler(int /*sig*/) {
+  gShouldStop = true;
+}
+
+static void printRenderTimingHistogram(HostAudioEngine &engine) {
+  RenderTimingStats stats;
+  engine.getRenderTimingStats(stats);
+  if(stats.callbacks == 0)
+    return;
+
+  printf("callback load histogram [fraction of period]:\n");
+  for(int i=0; i<RenderTimingStats::histogramBins; i++) {
+    if(stats.histogram[i] == 0)
+      continue;
+    if(i == RenderTimingStats::histogramBins-1)
+      printf("\t>= %3.0f%%: %u\n", 100 * i * RenderTimingStats::binWidth, stats.histogram[i]);
+    else
+      printf("\t%3.0f-%3.0f%%: %u\n", 100 * i * RenderTimingStats::binWidth, 100 * (i+1) * RenderTimingStats::binWidth, stats.histogram[i]);
+  }
+  printf("worst load: %.2f%%, overruns: %u\n", 100 * stats.worstLoad, stats.overruns);
+}
+
+static void usage(const char *name) {
+  printf("Usage: %s [options]\n", name);
+  printf("\t-p, --period <frames>       period size [default 384]\n");
+  printf("\t-r, --samplerate <Hz>       sample rate [default 48000]\n");
+  printf("\t-b, --block-size <frames>   fixed block size for render(), independent of the period [default 0, same as period]\n");
+  printf("\t-i, --in-channels <num>     number of input channels [default 1]\n");
+  printf("\t-o, --out-channels <num>    number of output channels [default 2]\n");
+  printf("\t-d, --duration <seconds>    how long to run, 0 runs until ctrl-c [default 10]\n");
+  printf("\t-f, --input-file <path>     audio file to loop into render()'s input [default silence]\n");
+  printf("\t-c, --capture-off           render() receives silence\n");
+  printf("\t-x, --offline               render the whole input file once, as fast as possible, ignoring duration\n");
+  printf("\t-w, --output-file <path>    where offline mode writes render()'s output [default output.wav]\n");
+  printf("\t-v, --verbose\n");
+  printf("\t-h, --help\n");
+}
+
+int main(int argc, char *argv[]) {
+  LDSPinitSettings settings;
+  settings.periodSize = 384;
+  settings.samplerate = 48000;
+  settings.captureOff = false;
+  settings.sensorsOff = true; // no sensors on the host
+  settings.parametersOff = false;
+  settings.verbose = false;
+  // not used on the host, there is no device buffer
+  settings.bufferCapacityMult = 2;
+  settings.performanceMode = perfMode_lowLatency;
+  settings.renderBlockSize = 0;
+  for(int i=0; i<LDSP_sensorsMax; i++)
+    settings.sensorRates[i] = sensorRate_block;
+
+  unsigned int inChannels = 1;
+  unsigned int outChannels = 2;
+  float duration = 10;
+  std::string inputFile;
+  bool offline = false;
+  std::string outputFile = "output.wav";
+
+  const struct option longOptions[] = {
+      {"period", required_argument, nullptr, 'p'},
+      {"samplerate", required_argument, nullptr, 'r'},
+      {"block-size", required_argument, nullptr, 'b'},
+      {"in-channels", required_argument, nullptr, 'i'},
+      {"out-channels", required_argument, nullptr, 'o'},
+      {"duration", required_argument, nullptr, 'd'},
+      {"input-file", required_argument, nullptr, 'f'},
+      {"capture-off", no_argument, nullptr, 'c'},
+      {"offline", no_argument, nullptr, 'x'},
+      {"output-file", required_argument, nullptr, 'w'},
+      {"verbose", no_argument, nullptr, 'v'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}
+  };
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "p:r:b:i:o:d:f:cxw:vh", longOptions, nullptr)) != -1) {
+    switch(opt) {
+      case 'p': settings.periodSize = atoi(optarg); break;
+      case 'r': settings.samplerate = atof(optarg); break;
+      case 'b': settings.renderBlockSize = atoi(optarg); break;
+      case 'i': inChannels = atoi(optarg); break;
+      case 'o': outChannels = atoi(optarg); break;
+      case 'd': duration = atof(optarg); break;
+      case 'f': inputFile = optarg; break;
+      case 'c': settings.captureOff = true; break;
+      case 'x': offline = true; break;
+      case 'w': outputFile = optarg; break;
+      case 'v': settings.verbose = true; break;
+      case 'h': usage(argv[0]); return 0;
+      default: usage(argv[0]); return 1;
+    }
+  }
+
+  if(settings.periodSize <= 0 || settings.samplerate <= 0 || settings.renderBlockSize < 0 || inChannels == 0 || outChannels == 0) {
+    fprintf(stderr, "Invalid audio settings\n");
+    return 1;
+  }
+
+  if(offline && inputFile.empty()) {
+    fprintf(stderr, "Offline mode needs an input file\n");
+    return 1;
+  }
+
+  HostAudioEngine engine;
+  engine.init(&settings, inChannels, outChannels);
+  engine.setRenderTimingEnabled(true);
+
+  std::vector<std::vector<float>> input;
+  if(!inputFile.empty()) {
+    input = AudioFileUtilities::load(inputFile);
+    if(input.empty() || input[0].empty()) {
+      fprintf(stderr, "Couldn't load input file %s\n", inputFile.c_str());
+      return 1;
+    }
+    engine.setInput(input);
+  }
+
+  if(offline) {
+    std::vector<std::vector<float>> output;
+    if(!engine.renderOffline(input, output))
+      return 1;
+    if(AudioFileUtilities::write(outputFile, output, settings.samplerate) <= 0) {
+      fprintf(stderr, "Couldn't write output file %s\n", outputFile.c_str());
+      return 1;
+    }
+
+    double seconds = input[0].size() / settings.samplerate;
+    printf("rendered %.2f s of audio in %.3f s [%.1fx real-time] to %s\n", seconds, engine.getOfflineRenderTimeS(), engine.getOfflineSpeed(), outputFile.c_str());
+    printf("%lu callbacks of %d frames, render() mean: %.2f us, max: %.2f us\n", engine.getCallbacks(), settings.periodSize, engine.getMeanRenderTimeUs(), engine.getMaxRenderTimeUs());
+    if(engine.getRenderBlockLatency() > 0)
+      printf("render() blocks of %d frames, %d frames of latency removed from the output file\n", settings.renderBlockSize, engine.getRenderBlockLatency());
+    if(settings.verbose)
+      printRenderTimingHistogram(engine);
+    return 0;
+  }
+
+  signal(SIGINT, interrupt_handler);
+  signal(SIGTERM, interrupt_handler);
+
+  if(!engine.start())
+    return 1;
+
+  // the audio thread does all the work, we just wait
+  float elapsed = 0;
+  while(!gShouldStop && (duration <= 0 || elapsed < duration)) {
+    usleep(100000);
+    elapsed += 0.1;
+  }
+  engine.stop();
+
+  double periodUs = engine.getPeriodUs();
+  printf("%lu callbacks of %d frames at %.0f Hz [period %.1f us]\n", engine.getCallbacks(), settings.periodSize, settings.samplerate, periodUs);
+  printf("render() mean: %.2f us (%.2f%% of period)\n", engine.getMeanRenderTimeUs(), 100.0 * engine.getMeanRenderTimeUs() / periodUs);
+  printf("render() max:  %.2f us (%.2f%% of period)\n", engine.getMaxRenderTimeUs(), 100.0 * engine.getMaxRenderTimeUs() / periodUs);
+  printf("deadline misses: %lu\n", engine.getDeadlineMisses());
+  if(engine.getRenderBlockLatency() > 0)
+    printf("render() blocks of %d frames, adding %d frames [%.2f ms] of latency\n", settings.renderBlockSize, engine.getRenderBlockLatency(),
+           1000.0 * engine.getRenderBlockLatency() / settings.samplerate);
+  printRenderTimingHistogram(engine);
+
+  return 0;
+}
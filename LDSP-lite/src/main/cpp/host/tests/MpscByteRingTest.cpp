@@ -0,0 +1,138 @@
+// Tests of the queue behind WSServer::send(), that is called from several threads at once
+// [e.g., the audio thread sending GUI buffers while the seasocks thread replies to a connection]
+// returns non-zero if any check fails, run via ctest in the host build
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "MpscByteRing.h"
+
+using namespace ldsplite;
+
+static int gFailures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); gFailures++; } } while(0)
+
+static uint8_t patternByte(uint32_t producer, uint32_t seq, uint32_t k) {
+  return (uint8_t)(producer*31 + seq*7 + k);
+}
+
+// full and empty ring, wrap markers, overflow count, from a single thread
+static void testSingleThread() {
+  MpscByteRing ring(256);
+  CHECK(ring.getCapacity() == 256);
+  CHECK(ring.isEmpty());
+
+  uint32_t size, tag;
+  CHECK(ring.beginRead(size, tag) == nullptr);
+  CHECK(ring.beginWrite(ring.getMaxRecordSize() + 1) == nullptr);
+  CHECK(ring.getOverflows() == 1);
+
+  // laps with a record size that does not divide the capacity, so that it wraps at different places
+  for(uint32_t seq=0; seq<100; seq++) {
+    uint8_t *rec = (uint8_t *)ring.beginWrite(20, seq);
+    CHECK(rec != nullptr);
+    if(rec == nullptr)
+      return;
+    memset(rec, (int)seq, 20);
+    // not visible until committed
+    CHECK(ring.beginRead(size, tag) == nullptr);
+    ring.commitWrite(rec);
+
+    const uint8_t *out = (const uint8_t *)ring.beginRead(size, tag);
+    CHECK(out != nullptr && size == 20 && tag == seq && out[0] == (uint8_t)seq && out[19] == (uint8_t)seq);
+    ring.endRead();
+    CHECK(ring.isEmpty());
+  }
+
+  // fill until it overflows, then get everything back in order
+  uint32_t written = 0;
+  void *rec;
+  while((rec = ring.beginWrite(24, written)) != nullptr) {
+    ring.commitWrite(rec);
+    written++;
+  }
+  CHECK(written > 0);
+  CHECK(ring.getOverflows() == 2);
+  for(uint32_t i=0; i<written; i++) {
+    CHECK(ring.beginRead(size, tag) != nullptr && tag == i);
+    ring.endRead();
+  }
+  CHECK(ring.beginRead(size, tag) == nullptr);
+}
+
+// two producers at the same time, each record must arrive once, intact and in the producer's order
+static void testTwoProducers() {
+  constexpr uint32_t numProducers = 2;
+  constexpr uint32_t recordsPerProducer = 200000;
+  MpscByteRing ring(4096);
+
+  std::atomic<bool> go{false};
+  std::vector<std::thread> producers;
+  for(uint32_t p=0; p<numProducers; p++) {
+    producers.emplace_back([&ring, &go, p]() {
+      while(!go)
+        std::this_thread::yield();
+      for(uint32_t seq=0; seq<recordsPerProducer; seq++) {
+        uint32_t size = sizeof(uint32_t) + seq % 200;
+        uint8_t *rec;
+        // full, wait for the consumer [only the test retries, send() drops]
+        while((rec = (uint8_t *)ring.beginWrite(size, p)) == nullptr)
+          std::this_thread::yield();
+        // sometimes get preempted half way, the other producer must not wait and the consumer must not read a partial record
+        if(seq % 16 == 0)
+          std::this_thread::yield();
+        memcpy(rec, &seq, sizeof(seq));
+        for(uint32_t k=sizeof(uint32_t); k<size; k++)
+          rec[k] = patternByte(p, seq, k);
+        ring.commitWrite(rec);
+      }
+    });
+  }
+
+  go = true;
+  uint32_t expected[numProducers] = {};
+  uint32_t received = 0;
+  int errors = 0;
+  while(received < numProducers*recordsPerProducer && errors < 10) {
+    uint32_t size, tag;
+    const uint8_t *rec = (const uint8_t *)ring.beginRead(size, tag);
+    if(rec == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t seq;
+    memcpy(&seq, rec, sizeof(seq));
+    bool ok = tag < numProducers && seq == expected[tag] && size == sizeof(uint32_t) + seq % 200;
+    for(uint32_t k=sizeof(uint32_t); ok && k<size; k++)
+      ok = rec[k] == patternByte(tag, seq, k);
+    if(!ok) {
+      printf("bad record: producer %u, seq %u, size %u\n", tag, seq, size);
+      errors++;
+    }
+    if(tag < numProducers)
+      expected[tag] = seq + 1;
+    ring.endRead();
+    received++;
+  }
+  for(auto &t : producers)
+    t.join();
+
+  CHECK(errors == 0);
+  CHECK(received == numProducers*recordsPerProducer);
+  CHECK(ring.isEmpty());
+}
+
+int main() {
+  testSingleThread();
+  testTwoProducers();
+
+  if(gFailures > 0) {
+    printf("MpscByteRing: %d checks failed\n", gFailures);
+    return 1;
+  }
+  printf("MpscByteRing: all checks passed\n");
+  return 0;
+}
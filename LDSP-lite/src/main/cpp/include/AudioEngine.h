@@ -0,0 +1,219 @@
+#pragma once
+
+#include "LDSP.h"
+#include "RenderTimer.h"
+#include "ParameterBus.h"
+#include "CtrlEventQueue.h"
+#include "interleave_utils.h"
+#include <atomic>
+#include <cstring> // memset
+#include <functional>
+#include <vector>
+
+namespace ldsplite {
+
+//VIC not a great solution to make internal context visible to sensors.cpp like in LDSP
+struct LDSPinternalContext {
+  float *audioIn;
+  float *audioOut;
+  uint32_t audioFrames;
+  uint32_t audioInChannels;
+  uint32_t audioOutChannels;
+  float audioSampleRate;
+  float *sensors;
+  int *ctrlInputs;
+  uint32_t sensorChannels;
+  bool *sensorsSupported;
+  string *sensorsDetails;
+  float controlSampleRate; // sensors and output devices
+  multiTouchInfo *mtInfo;
+  string projectName;
+  float *sliders;
+  uint32_t sliderCount;
+  LDSPlite *ldspLite;
+  bool audioPlanar;
+  float **audioInPlanar;
+  float **audioOutPlanar;
+  uint32_t renderBlockLatency;
+  const LDSPctrlEvent *ctrlEvents;
+  uint32_t ctrlEventCount;
+  uint64_t audioFramesElapsed;
+  bool ctrlInputsFloat;
+  float *ctrlInputsF;
+  buttonState *buttons;
+  uint32_t audioFramesMax;
+};
+//VIC and this is a terrible solution to share internal context with sensors.cpp as extern like in LDSP
+extern LDSPinternalContext intContext; // Declaration of the variable
+
+// Driver-independent part of the audio engine, i.e., everything that sits between the audio callback and render()
+// OboeAudioEngine drives it from Oboe's callbacks on Android, HostAudioEngine from a synthetic clock on a Linux host
+class AudioEngine {
+ public:
+  static constexpr int maxSliders = 64; // any number, update cost does not depend on it
+
+  AudioEngine(LDSPlite *ldspLite);
+  virtual ~AudioEngine() = default;
+
+  // render() always receives blocks of this size, no matter how many frames the driver passes to callRender()
+  // callbacks are buffered through a fifo, which adds one block of latency; 0 [default] renders each callback as is
+  // must be set before callSetup()
+  void setRenderBlockSize(int frames);
+  // frames, valid after callSetup()
+  int getRenderBlockLatency() const { return intContext.renderBlockLatency; }
+
+  // wrap the project's setup() and cleanup(), to be called by the drivers
+  // maxFrames is the largest audioFrames the driver may ever pass to callRender()
+  // if a render block size is set, setup() sees that as audioFrames instead
+  bool callSetup(int maxFrames);
+  void callCleanup();
+  void callRender(int audioFrames, float* audioIn, float* audioOut);
+
+  void setUpdateCtrlInBufferCallback(std::function<void()> callback) {
+    _updateCtrlInBufferCallback = callback;
+  }
+
+  // parameters [a.k.a. sliders] reach render() through a lock-free bus, can be called from any thread
+  // return false if index is not smaller than maxSliders
+  bool setParameter(int index, float value);
+  // changes are ramped linearly within rampMs, 0 [default] to jump to the new value at the next callback
+  bool setParameterSmoothing(int index, float rampMs);
+
+  // timestamped control event for render(), any thread [see LDSPctrlEvent]
+  // returns false if the event was dropped because the queue is full
+  bool postCtrlEvent(int type, int index, float v0, float v1 = 0, float v2 = 0, float v3 = 0);
+  // ctrlEvt_sensor sample taken at timeNs [on the monotonic_ns() clock], sensor thread
+  // sensor events have a queue of their own, so a burst of samples never takes the place of touch, button or parameter events
+  bool postSensorEvent(int64_t timeNs, int sensor, float v0, float v1 = 0, float v2 = 0, float v3 = 0);
+
+  // render() timing, off by default
+  void setRenderTimingEnabled(bool enabled);
+  void resetRenderTiming();
+  // meant to be polled from a non-RT thread
+  void getRenderTimingStats(RenderTimingStats &stats);
+  // number of xruns since the streams were opened, -1 if the driver cannot tell
+  virtual int getXRunCount() { return -1; }
+
+ protected:
+  LDSPcontext* userContext = nullptr;
+  ParameterBus _parameters{maxSliders};
+  bool _slidersOff;
+
+  std::function<void()> _updateCtrlInBufferCallback;
+
+  CtrlEventQueue _ctrlEvents;
+  CtrlEventQueue _sensorEvents;
+  // both queues' block events merged by frame, used only when there are sensor events in the block
+  LDSPctrlEvent _mergedEvents[2*CtrlEventQueue::capacity];
+  void collectCtrlEvents(uint64_t startFrame, int audioFrames);
+
+  RenderTimer _renderTimer;
+
+  // planar buffers, allocated only if requested in setup()
+  std::vector<float> _planarIn;
+  std::vector<float> _planarOut;
+  std::vector<float*> _planarInChannels;
+  std::vector<float*> _planarOutChannels;
+  void allocatePlanarBuffers(int maxFrames);
+
+  // fixed block fifo, one block per direction
+  // input is collected into _blockIn, while output is played from the block rendered the time before
+  int _renderBlockSize = 0;
+  int _blockPos = 0;
+  uint64_t _callbackFrame = 0; // frame clock, i.e., frames passed to callRender() since callSetup()
+  std::vector<float> _blockIn;
+  std::vector<float> _blockOut;
+  // startFrame is the frame clock of the block's first input frame
+  void renderBlock(int audioFrames, float* audioIn, float* audioOut, uint64_t startFrame);
+  void renderFixedBlocks(int audioFrames, float* audioIn, float* audioOut);
+};
+
+
+//----------------------------------
+
+inline void AudioEngine::callRender(int audioFrames, float* audioIn, float* audioOut) {
+  // timing covers everything that happens within the callback on our side, not only render()
+  bool timing = _renderTimer.isEnabled();
+  int64_t renderStart = 0;
+  if(timing)
+    renderStart = monotonic_ns();
+
+  // frame clock of this callback's first frame
+  uint64_t startFrame = intContext.audioFramesElapsed = _callbackFrame;
+  _callbackFrame += audioFrames;
+  _ctrlEvents.beginCallback(audioFrames);
+  _sensorEvents.beginCallback(audioFrames);
+
+  if(_renderBlockSize > 0)
+    renderFixedBlocks(audioFrames, audioIn, audioOut);
+  else
+    renderBlock(audioFrames, audioIn, audioOut, startFrame);
+
+  if(timing)
+    _renderTimer.record(renderStart, audioFrames, intContext.audioSampleRate);
+}
+
+inline void AudioEngine::renderBlock(int audioFrames, float* audioIn, float* audioOut, uint64_t startFrame) {
+  intContext.audioFrames = audioFrames;
+  intContext.audioIn = audioIn;
+  intContext.audioOut = audioOut;
+  intContext.audioFramesElapsed = startFrame;
+  collectCtrlEvents(startFrame, audioFrames);
+
+  // only parameters that changed or are ramping cost anything
+  if(!_slidersOff)
+    _parameters.update(audioFrames, intContext.audioSampleRate);
+
+  if (_updateCtrlInBufferCallback) {
+    _updateCtrlInBufferCallback();
+  }
+
+  // channel counts are fixed, so this is one branch per callback
+  // output starts as silence, so render() only needs to write the channels and frames it uses
+  if(intContext.audioPlanar) {
+    deinterleave(audioIn, intContext.audioInPlanar, audioFrames, intContext.audioInChannels);
+    for(unsigned int chn=0; chn<intContext.audioOutChannels; chn++)
+      memset(intContext.audioOutPlanar[chn], 0, audioFrames*sizeof(float));
+  }
+  else
+    memset(audioOut, 0, audioFrames*intContext.audioOutChannels*sizeof(float));
+
+  render(userContext, nullptr);
+
+  if(intContext.audioPlanar)
+    interleave(intContext.audioOutPlanar, audioOut, audioFrames, intContext.audioOutChannels);
+}
+
+inline bool AudioEngine::setParameter(int index, float value) {
+  if(!_parameters.set(index, value))
+    return false;
+  _ctrlEvents.post(ctrlEvt_parameter, index, value);
+  return true;
+}
+
+inline bool AudioEngine::setParameterSmoothing(int index, float rampMs) {
+  return _parameters.setSmoothing(index, rampMs);
+}
+
+inline bool AudioEngine::postCtrlEvent(int type, int index, float v0, float v1, float v2, float v3) {
+  return _ctrlEvents.post(type, index, v0, v1, v2, v3);
+}
+
+inline bool AudioEngine::postSensorEvent(int64_t timeNs, int sensor, float v0, float v1, float v2, float v3) {
+  return _sensorEvents.postAt(timeNs, ctrlEvt_sensor, sensor, v0, v1, v2, v3);
+}
+
+inline void AudioEngine::setRenderTimingEnabled(bool enabled) {
+  _renderTimer.setEnabled(enabled);
+}
+
+inline void AudioEngine::resetRenderTiming() {
+  _renderTimer.reset();
+}
+
+inline void AudioEngine::getRenderTimingStats(RenderTimingStats &stats) {
+  _renderTimer.getStats(stats);
+  stats.xruns = getXRunCount();
+}
+
+}  // namespace ldsplite
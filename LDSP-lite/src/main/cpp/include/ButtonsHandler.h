@@ -0,0 +1,77 @@
+//
+// Created by vic on 9/1/25.
+//
+
+#ifndef LDSP_LITE_LDSP_LITE_SRC_MAIN_CPP_INCLUDE_BUTTONSHANDLER_H_
+#define LDSP_LITE_LDSP_LITE_SRC_MAIN_CPP_INCLUDE_BUTTONSHANDLER_H_
+
+#include "LDSP.h"
+#include <atomic>
+#include <cstdint>
+
+namespace ldsplite {
+
+// Hardware key events come from the UI thread, the audio thread reads them once per block
+// each button is a single atomic word that packs how many times it was pressed [high 32 bits] and released [low 32 bits],
+// so the reader gets a consistent pair with one load: the button is down if presses > releases,
+// and the difference with the pair seen in the previous block gives the edges, even when a tap is shorter than a block
+class ButtonsHandler {
+ public:
+  ButtonsHandler() {
+    for (auto &counters : _counters)
+      counters.store(0, std::memory_order_relaxed);
+  }
+
+  // any thread; key repeats [a held button] and releases of buttons that are not down are ignored
+  // returns true if the state actually changed
+  bool updateButton(int channel, bool pressed) {
+    if (channel < 0 || channel >= chn_btn_count) return false;
+
+    // the check and the update are one CAS, so concurrent writers cannot both count the same edge
+    uint64_t counters = _counters[channel].load(std::memory_order_relaxed);
+    do {
+      if (isDown(counters) == pressed)
+        return false;
+    } while (!_counters[channel].compare_exchange_weak(counters, counters + (pressed ? kPress : kRelease),
+                                                       std::memory_order_release, std::memory_order_relaxed));
+    return true;
+  }
+
+  // audio thread only
+  // button state into ctrlInputs [1 down, 0 up] and edges since the previous call into buttons
+  // T is int or float
+  template<typename T>
+  void populate(T* ctrlInputs, buttonState* buttons) {
+    for (int chn = 0; chn < chn_btn_count; ++chn) {
+      uint64_t counters = _counters[chn].load(std::memory_order_acquire);
+      uint32_t presses = static_cast<uint32_t>(counters >> 32);
+      uint32_t releases = static_cast<uint32_t>(counters);
+
+      ctrlInputs[chn] = static_cast<T>(isDown(counters) ? 1 : 0);
+      // unsigned differences, fine across wrap around
+      buttons[chn].pressed = presses - _seenPresses[chn];
+      buttons[chn].released = releases - _seenReleases[chn];
+      buttons[chn].pressCount = presses;
+      _seenPresses[chn] = presses;
+      _seenReleases[chn] = releases;
+    }
+  }
+
+ private:
+  static constexpr uint64_t kPress = uint64_t(1) << 32;
+  static constexpr uint64_t kRelease = 1;
+
+  static bool isDown(uint64_t counters) {
+    return static_cast<uint32_t>(counters >> 32) != static_cast<uint32_t>(counters);
+  }
+
+  std::atomic<uint64_t> _counters[chn_btn_count];
+
+  // reader side
+  uint32_t _seenPresses[chn_btn_count] = {};
+  uint32_t _seenReleases[chn_btn_count] = {};
+};
+
+} // namespace ldsplite
+
+#endif //LDSP_LITE_LDSP_LITE_SRC_MAIN_CPP_INCLUDE_BUTTONSHANDLER_H_
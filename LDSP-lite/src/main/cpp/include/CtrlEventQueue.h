@@ -0,0 +1,68 @@
+#pragma once
+
+#include "LDSP.h"
+#include "thread_utils.h"
+#include <atomic>
+#include <cstdint>
+
+namespace ldsplite {
+
+// Timestamped control events [touch, parameters...] on their way to render()
+// any number of threads post() events, which are stamped with monotonic_ns() and go through a bounded lock-free queue
+// once per callback, the audio thread maps the stamps onto the audio frame clock: an event that happened x% into the previous
+// callback's interval lands x% into the current callback, so that relative timing is kept to the sample, at the cost of one period of delay
+// events are then handed to each render() as a list sorted by frame offset within the block
+class CtrlEventQueue {
+ public:
+  static constexpr int capacity = 256; // power of 2; if the queue is full, post() fails
+
+  CtrlEventQueue();
+
+  // any thread
+  bool post(int type, int index, float v0, float v1 = 0, float v2 = 0, float v3 = 0);
+  // same, for events that carry their own time [e.g., sensor samples], timeNs is on the monotonic_ns() clock
+  bool postAt(int64_t timeNs, int type, int index, float v0, float v1 = 0, float v2 = 0, float v3 = 0);
+  // events that did not make it because the queue was full
+  uint32_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  // audio thread only
+  // clears the frame clock and drops anything still queued, to be called before the driver starts
+  void reset();
+  // to be called at the beginning of each callback, before any collect()
+  void beginCallback(int audioFrames);
+  // moves the events that fall within [startFrame, startFrame+frames) into getBlockEvents(), with frame offsets relative to startFrame
+  // events that belong to a later block stay pending, returns how many were moved
+  int collect(uint64_t startFrame, int frames);
+  const LDSPctrlEvent *getBlockEvents() const { return _blockEvents; }
+
+ private:
+  static constexpr uint32_t mask = capacity - 1;
+
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    int64_t timeNs;
+    LDSPctrlEvent event;
+  };
+  struct PendingEvent {
+    uint64_t frame; // on the absolute frame clock
+    LDSPctrlEvent event;
+  };
+
+  // queue, Vyukov-style: each cell's sequence number tells whether it is free for the producer at that position or ready for the consumer
+  Cell _cells[capacity];
+  std::atomic<uint32_t> _enqueuePos{0};
+  uint32_t _dequeuePos = 0;
+  std::atomic<uint32_t> _dropped{0};
+
+  // audio thread state
+  uint64_t _nextFrame = 0; // frame clock at the beginning of the next callback
+  int64_t _prevCallbackNs = 0;
+  PendingEvent _pending[capacity]; // sorted by frame
+  int _numPending = 0;
+  LDSPctrlEvent _blockEvents[capacity];
+
+  bool pop(int64_t &timeNs, LDSPctrlEvent &event);
+  void insertPending(uint64_t frame, const LDSPctrlEvent &event);
+};
+
+}  // namespace ldsplite
@@ -7,7 +7,8 @@
 
 
 #include "TouchHandler.h"
-#include "OboeAudioEngine.h" // for LDSPinternalContext
+#include "ButtonsHandler.h"
+#include "AudioEngine.h" // for LDSPinternalContext
 #include "LDSP.h"
 #include <memory>
 #include <cstring>
@@ -20,6 +21,9 @@ class CtrlInputs {
     _totalSize = chn_btn_count + 1 + (chn_mt_count - 1) * TouchHandler::MAX_SLOTS;
     _ctrlInputsBuffer = std::make_unique<int[]>(_totalSize);
     std::memset(_ctrlInputsBuffer.get(), 0, _totalSize * sizeof(int));
+    _ctrlInputsBufferF = std::make_unique<float[]>(_totalSize);
+    std::memset(_ctrlInputsBufferF.get(), 0, _totalSize * sizeof(float));
+    std::memset(_buttons, 0, sizeof(_buttons));
 
     _mtInfo.touchSlots = TouchHandler::MAX_SLOTS;
     _mtInfo.touchAxisMax = 1000;
@@ -30,8 +34,16 @@ class CtrlInputs {
   }
 
   void setupContext(LDSPinternalContext* context) {
+    _context = context;
     context->ctrlInputs = _ctrlInputsBuffer.get();
+    context->ctrlInputsF = _ctrlInputsBufferF.get();
     context->mtInfo = &_mtInfo;
+    context->buttons = _buttons;
+  }
+
+  // Buttons delegating method, returns true if the button state changed
+  bool updateButton(int channel, bool pressed) {
+    return _buttonsHandler.updateButton(channel, pressed);
   }
 
   // Touch delegating methods
@@ -47,6 +59,10 @@ class CtrlInputs {
                               majWidth, minWidth);
   }
 
+  void updateTouchBatch(const float* records, int count, int anyTouch) {
+    _touchHandler.updateBatch(records, count, anyTouch);
+  }
+
   void updateHover(int slot, float hoverX, float hoverY) {
     _touchHandler.updateHover(slot, hoverX, hoverY);
   }
@@ -62,23 +78,32 @@ class CtrlInputs {
   }
 
   // Update buffer from handlers
+  // only the buffer the project asked for is updated
   void updateBuffer() {
+    if (_context != nullptr && _context->ctrlInputsFloat) {
+      _touchHandler.populateCtrlInputsF(_ctrlInputsBufferF.get(), _mtInfo.touchSlots);
+      _buttonsHandler.populate(_ctrlInputsBufferF.get(), _buttons);
+      return;
+    }
+
     // Update from touch handler
     _touchHandler.populateCtrlInputs(_ctrlInputsBuffer.get(), _mtInfo.touchSlots);
 
-    // TODO: Update from buttons handler
-    _ctrlInputsBuffer[chn_btn_power] = 0;
-    _ctrlInputsBuffer[chn_btn_volUp] = 0;
-    _ctrlInputsBuffer[chn_btn_volDown] = 0;
+    // Update from buttons handler
+    _buttonsHandler.populate(_ctrlInputsBuffer.get(), _buttons);
   }
 
   int* getBuffer() { return _ctrlInputsBuffer.get(); }
+  float* getBufferF() { return _ctrlInputsBufferF.get(); }
   const multiTouchInfo* getMultiTouchInfo() const { return &_mtInfo; }
 
  private:
   TouchHandler _touchHandler;  // Owned by CtrlInputs
-  // Future: ButtonsHandler _buttonsHandler;
+  ButtonsHandler _buttonsHandler;
+  buttonState _buttons[chn_btn_count];
   std::unique_ptr<int[]> _ctrlInputsBuffer;
+  std::unique_ptr<float[]> _ctrlInputsBufferF;
+  LDSPinternalContext* _context = nullptr;
   multiTouchInfo _mtInfo;
   int _totalSize;
 };
@@ -24,14 +24,31 @@ class LDSPlite;  // Forward declaration
 //VIC this is a terrible kludge to keep the same API as LDSP...
 #define LDSP_requestStop() context->ldspLite->stop()
 
+enum audioPerformanceMode {
+  perfMode_none,
+  perfMode_powerSaving,
+  perfMode_lowLatency
+};
+
+// room for all the sensors LDSP knows of [see LDSP_sensor in sensors.h]
+constexpr int LDSP_sensorsMax = 16;
+
+// special values for LDSPinitSettings::sensorRates
+constexpr float sensorRate_block = 0; // one sample per render() block, i.e., controlSampleRate
+constexpr float sensorRate_max = -1; // as fast as the sensor goes
+
 struct LDSPinitSettings {
   // these items might be adjusted by the user:
-  int periodSize;
-  float samplerate;
+  int periodSize; // rounded to the closest multiple of the device's burst size
+  float samplerate; // 0 for the device's native rate
   int captureOff;
   int sensorsOff;
   int parametersOff; //VIC LDSPlite only
   int verbose;
+  int bufferCapacityMult; //VIC LDSPlite only, buffer capacity in periods
+  int performanceMode; //VIC LDSPlite only, one of audioPerformanceMode
+  int renderBlockSize; //VIC LDSPlite only, fixed audioFrames for render() regardless of the callback size, 0 to follow the callbacks
+  float sensorRates[LDSP_sensorsMax]; //VIC LDSPlite only, target rate per LDSP_sensor [Hz], or sensorRate_block/sensorRate_max
 };
 
 struct multiTouchInfo {
@@ -42,6 +59,31 @@ struct multiTouchInfo {
   bool anyTouchSupported;
 };
 
+enum ctrlEventType {
+  ctrlEvt_anyTouch,  // values[0] is the new state
+  ctrlEvt_touch,     // index is the slot, values are x, y [pixels], pressure [0-1] and id
+  ctrlEvt_touchEnd,  // index is the slot
+  ctrlEvt_hover,     // index is the slot, values are hoverX and hoverY
+  ctrlEvt_parameter, // index is the parameter/slider, values[0] is the new value [before smoothing]
+  ctrlEvt_button,    // index is the button [btnInputChannel], values[0] is 1 when pressed and 0 when released
+  ctrlEvt_sensor     // index is the sensor, values are its channels in sensorChannel order [e.g., accelX, accelY, accelZ], placed at the frame where they were sampled
+};
+
+// what a hardware button did since the previous block [see context->buttons]
+struct buttonState {
+  uint32_t pressed; // number of presses, can be more than 0 while the button is up, if a tap was shorter than a block
+  uint32_t released;
+  uint32_t pressCount; // total presses since the app started
+};
+
+// a control input change, placed at the audio frame where it happened [see context->ctrlEvents]
+struct LDSPctrlEvent {
+  uint32_t frame; // offset within the current block
+  int type; // one of ctrlEventType
+  int index;
+  float values[4];
+};
+
 struct LDSPcontext {
   const float * const audioIn;
   float * const audioOut;
@@ -58,7 +100,24 @@ struct LDSPcontext {
   const multiTouchInfo * const mtInfo;
   const string projectName;
   float * const sliders;
+  const uint32_t sliderCount;
   ldsplite::LDSPlite * const ldspLite;
+  // planar view of the audio buffers, only valid if audioPlanar is true [see LDSP_requestPlanarAudio()]
+  const bool audioPlanar;
+  const float * const * const audioInPlanar; // one contiguous array of audioFrames samples per input channel
+  float * const * const audioOutPlanar; // one contiguous array of audioFrames samples per output channel
+  // frames of delay added by buffering callbacks into fixed render blocks [see LDSPinitSettings::renderBlockSize], 0 if not used
+  const uint32_t renderBlockLatency;
+  // control events since the previous block, sorted by frame; they are delivered one period after they happened,
+  // but with sample-accurate spacing, while ctrlInputs and sliders are a snapshot taken at the beginning of the block
+  const LDSPctrlEvent * const ctrlEvents;
+  const uint32_t ctrlEventCount;
+  const uint64_t audioFramesElapsed; // frame clock at the beginning of this block
+  // float version of ctrlInputs, same layout, only valid if ctrlInputsFloat is true [see LDSP_requestFloatCtrlInputs()]
+  const bool ctrlInputsFloat;
+  const float * const ctrlInputsF;
+  const buttonState * const buttons; // one per btnInputChannel, their up/down state is in ctrlInputs
+  const uint32_t audioFramesMax; // largest audioFrames render() will ever get, for buffers allocated in setup()
 };
 
 enum sensorChannel {
@@ -73,6 +132,22 @@ enum sensorChannel {
   chn_sens_gyroZ,
   chn_sens_light,
   chn_sens_proximity,
+  // the following need API level 18 [see sensors.h]
+  chn_sens_rotVecX,
+  chn_sens_rotVecY,
+  chn_sens_rotVecZ,
+  chn_sens_rotVecW,
+  chn_sens_gameRotVecX,
+  chn_sens_gameRotVecY,
+  chn_sens_gameRotVecZ,
+  chn_sens_gameRotVecW,
+  chn_sens_linAccelX,
+  chn_sens_linAccelY,
+  chn_sens_linAccelZ,
+  chn_sens_gravityX,
+  chn_sens_gravityY,
+  chn_sens_gravityZ,
+  chn_sens_pressure,
   chn_sens_count
 };
 
@@ -102,6 +177,15 @@ enum multiTouchInputChannel {
 void LDSP_initSensors(LDSPinitSettings *settings);
 void LDSP_cleanupSensors();
 
+// to be called in setup()
+// audio is then also deinterleaved into context->audioInPlanar before each render(),
+// while output must be written into context->audioOutPlanar, which is interleaved into context->audioOut after render()
+void LDSP_requestPlanarAudio(LDSPcontext *context);
+// to be called in setup()
+// control inputs are then written into context->ctrlInputsF as floats, with no truncation [sub-pixel coordinates, pressure in 0-1]
+// the int buffer is not updated anymore, so multiTouchRead() has to be replaced by multiTouchReadF()
+void LDSP_requestFloatCtrlInputs(LDSPcontext *context);
+
 
 bool setup(LDSPcontext *context, void *userData);
 /**
@@ -114,8 +198,15 @@ void cleanup(LDSPcontext *context, void *userData);
 
 static inline float audioRead(LDSPcontext *context, int frame, int channel);
 static inline void audioWrite(LDSPcontext *context, int frame, int channel, float value);
+static inline float audioReadNI(LDSPcontext *context, int frame, int channel);
+static inline void audioWriteNI(LDSPcontext *context, int frame, int channel, float value);
 
 static inline int multiTouchRead(LDSPcontext *context, multiTouchInputChannel channel, int touchSlot=0);
+static inline float multiTouchReadF(LDSPcontext *context, multiTouchInputChannel channel, int touchSlot=0);
+
+static inline int buttonRead(LDSPcontext *context, btnInputChannel channel);
+static inline int buttonPressed(LDSPcontext *context, btnInputChannel channel);
+static inline int buttonReleased(LDSPcontext *context, btnInputChannel channel);
 
 static inline float sliderRead(LDSPcontext *context, int parameterNum);
 static inline void sliderWrite(LDSPcontext *context, int parameterNum, float value);
@@ -139,6 +230,22 @@ static inline void audioWrite(LDSPcontext *context, int frame, int channel, floa
   context->audioOut[frame * context->audioOutChannels + channel] = value;
 }
 
+// audioReadNI()
+//
+// Non-interleaved version of audioRead(), requires LDSP_requestPlanarAudio()
+static inline float audioReadNI(LDSPcontext *context, int frame, int channel)
+{
+  return context->audioInPlanar[channel][frame];
+}
+
+// audioWriteNI()
+//
+// Non-interleaved version of audioWrite(), requires LDSP_requestPlanarAudio()
+static inline void audioWriteNI(LDSPcontext *context, int frame, int channel, float value)
+{
+  context->audioOutPlanar[channel][frame] = value;
+}
+
 static inline int multiTouchRead(LDSPcontext *context, multiTouchInputChannel channel, int touchSlot)
 {
   if(channel==chn_mt_anyTouch)
@@ -147,10 +254,49 @@ static inline int multiTouchRead(LDSPcontext *context, multiTouchInputChannel ch
     return context->ctrlInputs[chn_btn_count+1+(channel-1)*context->mtInfo->touchSlots + touchSlot];
 }
 
+// multiTouchReadF()
+//
+// Float version of multiTouchRead(), requires LDSP_requestFloatCtrlInputs()
+// pressure is in 0-1 rather than 0-1000
+static inline float multiTouchReadF(LDSPcontext *context, multiTouchInputChannel channel, int touchSlot)
+{
+  if(channel==chn_mt_anyTouch)
+    return context->ctrlInputsF[chn_btn_count+chn_mt_anyTouch];
+  else
+    return context->ctrlInputsF[chn_btn_count+1+(channel-1)*context->mtInfo->touchSlots + touchSlot];
+}
+
+// buttonRead()
+//
+// Returns 1 while the given hardware button is held down, 0 otherwise
+static inline int buttonRead(LDSPcontext *context, btnInputChannel channel)
+{
+  if(context->ctrlInputsFloat)
+    return (int)context->ctrlInputsF[channel];
+  return context->ctrlInputs[channel];
+}
+
+// buttonPressed()
+//
+// Returns how many times the given hardware button was pressed since the previous block, usually 0 or 1
+static inline int buttonPressed(LDSPcontext *context, btnInputChannel channel)
+{
+  return context->buttons[channel].pressed;
+}
+
+// buttonReleased()
+//
+// Returns how many times the given hardware button was released since the previous block, usually 0 or 1
+static inline int buttonReleased(LDSPcontext *context, btnInputChannel channel)
+{
+  return context->buttons[channel].released;
+}
+
 
 // sliderRead()
 //
 // LDSPlite only - Returns the most recent value of the given GUI parameter
+// if smoothing is on for this parameter, this is where the ramp is at the end of the current block
 static inline float sliderRead(LDSPcontext *context, int parameterNum)
 {
   return context->sliders[parameterNum];
@@ -159,6 +305,7 @@ static inline float sliderRead(LDSPcontext *context, int parameterNum)
 // sliderWrite()
 //
 // LDSPlite only - Sets a given GUI parameter to a value (it updates the GUI)
+// the value holds until the parameter is set again from outside, or an ongoing ramp moves it
 static inline void sliderWrite(LDSPcontext *context, int parameterNum, float value)
 {
   context->sliders[parameterNum] = value;
@@ -1,10 +1,19 @@
 #pragma once
 
+#ifdef __ANDROID__
 #include <android/log.h>
+#else
+#include <cstdio> // host build, logs go to stdout
+#endif
 
 #ifndef NDEBUG
+#ifdef __ANDROID__
 #define LDSP_log(args...) \
 __android_log_print(android_LogPriority::ANDROID_LOG_DEBUG, "LDSP-lite", args)
 #else
+#define LDSP_log(args...) \
+do { printf(args); printf("\n"); } while(0)
+#endif
+#else
 #define LDSP_log(args...)
 #endif
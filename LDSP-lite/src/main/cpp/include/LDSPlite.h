@@ -3,6 +3,8 @@
 #include <memory>
 #include <mutex>
 #include "CtrlInputs.h"
+#include "RenderTimer.h"
+#include "fullduplex/DriftCompensator.h"
 
 namespace ldsplite {
 
@@ -20,23 +22,52 @@ class LDSPlite {
 
   bool isStarted() const;
 
+  // these take effect at the next start()
+  bool setChannelCounts(int inChannels, int outChannels);
+  // periodSize is rounded to the closest multiple of the device's burst size, samplerate 0 means native
+  void setAudioSettings(int periodSize, float samplerate, int bufferCapacityMult, int performanceMode);
+  // render() always gets blocks of this size, at the cost of one block of latency; 0 follows the callbacks
+  void setRenderBlockSize(int frames);
+  void setLatencyTuning(bool enabled);
+
+  // see OboeAudioEngine::latencyTunerState
+  int getLatencyTunerState();
+  int getOutputBufferSize();
+  // frames added by the render block fifo, 0 if not used
+  int getRenderBlockLatency();
+  // input is resampled to follow the output clock, see FullDuplexStream::setDriftCompensation()
+  void setDriftCompensation(bool enabled);
+  void getDriftStats(DriftCompensatorStats &stats);
+  // sensor is an LDSP_sensor index, rate in Hz or one of sensorRate_block/sensorRate_max; takes effect at the next start()
+  void setSensorRate(int sensor, float rate);
+  // effective rate of each sensor [Hz], measured while running; returns how many were written
+  int getSensorRates(float *rates, int count);
+
   void updateAnyTouch(int state);
   void updateTouch(int slot, int id, float x, float y, float pressure,
                    float majAxis, float minAxis, float orientation,
                    float majWidth, float minWidth);
+  // records as described in TouchHandler::BATCH_RECORD_SIZE, anyTouch -1 to leave it as it is
+  void updateTouchBatch(const float* records, int count, int anyTouch);
   void updateHover(int slot, float hoverX, float hoverY);
   void clearTouch(int slot);
   void setScreenResolution(float width, float height);
+  // channel is one of btnInputChannel
+  void updateButton(int channel, bool pressed);
+
+  // any number of parameters up to AudioEngine::maxSliders, read in render() via sliderRead()
+  void setParameter(int index, float value);
+  void setParameterSmoothing(int index, float rampMs);
 
-  void setSlider0(float value);
-  void setSlider1(float value);
-  void setSlider2(float value);
-  void setSlider3(float value);
+  void setRenderTimingEnabled(bool enabled);
+  void resetRenderTiming();
+  void getRenderTimingStats(RenderTimingStats &stats);
 
  private:
   std::atomic<bool> _isStarted{false};
   std::mutex _mutex;
   std::unique_ptr<OboeAudioEngine> _audioEngine;
+  LDSPinitSettings _settings; // requested, what we actually get is logged at start()
   CtrlInputs _ctrlInputs;
 };
 
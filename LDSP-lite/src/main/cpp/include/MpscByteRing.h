@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace ldsplite {
+
+// Multiple producers single consumer queue of variable-length byte records, no locks and no allocations after construction
+// each record is a small header followed by its payload, padded to 8 bytes, and is always contiguous in memory:
+// if it does not fit before the end of the buffer, a wrap marker fills the gap and the record starts over at the beginning
+// producers reserve room with a CAS on the head, write in place [beginWrite()] and then publish the record by setting the ready bit in its header [commitWrite()],
+// so they never wait for each other; the consumer reads in place [beginRead()/endRead()], in order, and stops at the first record that is not published yet
+// [a producer that is preempted between beginWrite() and commitWrite() only holds back the consumer, never the other producers]
+// the consumer zeroes what it has read, so that a header that is not published yet always reads as not ready
+// if there is no room, beginWrite() fails right away and the record is counted as an overflow, nothing ever blocks or gets overwritten
+class MpscByteRing {
+ public:
+  // capacity in bytes, rounded up to a power of 2
+  explicit MpscByteRing(uint32_t capacity) {
+    _capacity = 64;
+    while(_capacity < capacity)
+      _capacity <<= 1;
+    _mask = _capacity - 1;
+    _buffer = std::make_unique<uint64_t[]>(_capacity / sizeof(uint64_t)); // 8-byte aligned and zeroed
+  }
+
+  uint32_t getCapacity() const { return _capacity; }
+  // largest payload that can ever fit
+  uint32_t getMaxRecordSize() const { return _capacity/2 - headerSize; }
+
+  // any producer
+  // returns where to write size bytes of payload, or nullptr if there is no room; nothing is visible to the consumer until commitWrite()
+  void *beginWrite(uint32_t size, uint32_t tag = 0) {
+    if(size > getMaxRecordSize()) {
+      _overflows.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    uint32_t recordBytes = recordSize(size);
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t needed;
+    do {
+      uint32_t toEnd = _capacity - (head & _mask);
+      // if the record does not fit before the end, the rest of this lap is wasted
+      needed = (toEnd < recordBytes) ? toEnd + recordBytes : recordBytes;
+      // acquire, so that the consumer is done zeroing what we are about to reserve
+      if(needed > _capacity - (head - _tail.load(std::memory_order_acquire))) {
+        _overflows.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+    } while(!_head.compare_exchange_weak(head, head + needed, std::memory_order_relaxed));
+
+    // the range [head, head + needed) is ours
+    if(needed != recordBytes) {
+      header(head)->tag = 0;
+      state(header(head)).store(wrapMarker | readyBit, std::memory_order_release);
+      head += needed - recordBytes;
+    }
+    Header *hdr = header(head);
+    hdr->tag = tag;
+    state(hdr).store(size, std::memory_order_relaxed); // not ready yet
+    return hdr + 1;
+  }
+
+  // the producer that got record from beginWrite()
+  void commitWrite(void *record) {
+    Header *hdr = static_cast<Header *>(record) - 1;
+    std::atomic<uint32_t> &st = state(hdr);
+    // release, so that the consumer sees the whole record once it sees the ready bit
+    st.store(st.load(std::memory_order_relaxed) | readyBit, std::memory_order_release);
+  }
+
+  // bytes a producer could use right now, an upper bound for the next payload [wrapping may waste some]
+  uint32_t getFreeSpace() const {
+    uint32_t used = _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire);
+    uint32_t free = _capacity - used;
+    return (free > headerSize) ? free - headerSize : 0;
+  }
+
+  // consumer only
+  // returns the oldest record's payload, or nullptr if the ring is empty or the oldest record is not published yet
+  // the record stays in the ring until endRead()
+  const void *beginRead(uint32_t &size, uint32_t &tag) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    for(;;) {
+      Header *hdr = header(tail);
+      uint32_t st = state(hdr).load(std::memory_order_acquire);
+      if((st & readyBit) == 0)
+        return nullptr;
+
+      if((st & ~readyBit) == wrapMarker) {
+        uint32_t gap = _capacity - (tail & _mask);
+        memset(hdr, 0, gap);
+        tail += gap;
+        _tail.store(tail, std::memory_order_release);
+        continue;
+      }
+      size = st & ~readyBit;
+      tag = hdr->tag;
+      return hdr + 1;
+    }
+  }
+
+  void endRead() {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    Header *hdr = header(tail);
+    uint32_t recordBytes = recordSize(state(hdr).load(std::memory_order_relaxed) & ~readyBit);
+    memset(hdr, 0, recordBytes);
+    // release, so that producers see the zeroes once they see the new tail
+    _tail.store(tail + recordBytes, std::memory_order_release);
+  }
+
+  // true if nothing is queued, including records that are reserved but not published yet
+  bool isEmpty() const {
+    return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire);
+  }
+
+  // records that did not fit
+  uint32_t getOverflows() const { return _overflows.load(std::memory_order_relaxed); }
+
+ private:
+  struct Header {
+    uint32_t state; // payload bytes [or wrapMarker] and readyBit, accessed atomically via state()
+    uint32_t tag; // free for the user, e.g., the record type
+  };
+  static constexpr uint32_t headerSize = sizeof(Header);
+  static constexpr uint32_t readyBit = 0x80000000;
+  static constexpr uint32_t wrapMarker = 0x7FFFFFFF;
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "MpscByteRing needs a plain 32-bit atomic");
+
+  static uint32_t recordSize(uint32_t size) {
+    return headerSize + ((size + 7) & ~uint32_t(7));
+  }
+  Header *header(uint32_t pos) const {
+    return reinterpret_cast<Header *>(reinterpret_cast<char *>(_buffer.get()) + (pos & _mask));
+  }
+  static std::atomic<uint32_t> &state(Header *hdr) {
+    return *reinterpret_cast<std::atomic<uint32_t> *>(&hdr->state);
+  }
+
+  uint32_t _capacity;
+  uint32_t _mask;
+  std::unique_ptr<uint64_t[]> _buffer;
+
+  alignas(64) std::atomic<uint32_t> _head{0}; // reserved by the producers
+  alignas(64) std::atomic<uint32_t> _tail{0}; // written by the consumer
+  alignas(64) std::atomic<uint32_t> _overflows{0};
+};
+
+}  // namespace ldsplite
@@ -1,42 +1,34 @@
 #pragma once
 
 #include <oboe/Oboe.h>
-#include "LDSP.h"
+#include <pthread.h>
+#include "AudioEngine.h"
 #include "fullduplex/FullDuplexStream.h"
-#include <atomic>
 
 namespace ldsplite {
 
-//VIC not a great solution to make internal context visible to sensors.cpp like in LDSP
-struct LDSPinternalContext {
-  float *audioIn;
-  float *audioOut;
-  uint32_t audioFrames;
-  uint32_t audioInChannels;
-  uint32_t audioOutChannels;
-  float audioSampleRate;
-  float *sensors;
-  int *ctrlInputs;
-  uint32_t sensorChannels;
-  bool *sensorsSupported;
-  string *sensorsDetails;
-  float controlSampleRate; // sensors and output devices
-  multiTouchInfo *mtInfo;
-  string projectName;
-  float *sliders;
-  LDSPlite *ldspLite;
-};
-//VIC and this is a terrible solution to share internal context with sensors.cpp as extern like in LDSP
-extern LDSPinternalContext intContext; // Declaration of the variable
-
-class OboeAudioEngine : public FullDuplexStream {
+class OboeAudioEngine : public AudioEngine, public FullDuplexStream {
  public:
-  static constexpr auto channelCount = oboe::ChannelCount::Mono;
+  enum latencyTunerState {
+    tuner_off,
+    tuner_tuning,
+    tuner_done,
+    tuner_unsupported // no xrun count, i.e., OpenSL ES
+  };
 
   OboeAudioEngine(LDSPlite *ldspLite);
   ~OboeAudioEngine();
 
-  void init();
+  // most devices cap streams at 8 channels, higher requests are refused rather than silently downmixed
+  static constexpr int maxChannelCount = 8;
+
+  // requested channel counts, must be set before init(); both default to mono, projects opt into more channels here
+  // actual counts are read back from the streams, and are what render() sees in the context
+  // counts outside [1, maxChannelCount] are rejected and the previous ones are kept
+  bool setChannelCounts(int inChannels, int outChannels);
+  // opens the streams with the requested period size, sample rate, buffer capacity and performance mode
+  // then overwrites settings with the values actually granted by the device
+  oboe::Result init(LDSPinitSettings *settings);
   oboe::Result start() override;
   oboe::Result stop() override;
 
@@ -55,63 +47,49 @@ class OboeAudioEngine : public FullDuplexStream {
       int   numOutputFrames
   ) override;
 
-  void callRender(int audioFrames, float* audioIn, float* audioOut);
+  int getXRunCount() override;
+
+  // latency tuner, must be enabled before start()
+  // starting from the whole buffer capacity, it shrinks the output buffer size one burst at a time until underruns show up,
+  // then it backs off one step and leaves it there
+  void setLatencyTuning(bool enabled);
+  int getLatencyTunerState();
+  int getOutputBufferSize(); // frames, -1 if not available
 
-  void setUpdateCtrlInBufferCallback(std::function<void()> callback) {
-    _updateCtrlInBufferCallback = callback;
-  }
-  
   float getSampleRate();
   int getFramesPerCallback();
   int getFullDuplex();
-  void setSlider0(float param);
-  void setSlider1(float param);
-  void setSlider2(float param);
-  void setSlider3(float param);
+  int getInChannels();
+  int getOutChannels();
 
  private:
   std::shared_ptr<oboe::AudioStream> _outStream = nullptr;
   std::shared_ptr<oboe::AudioStream> _inStream = nullptr;
   int _sampleRate = 0;
   int _bufferSize = 384;
-  LDSPcontext* userContext = nullptr;
+  int _bufferCapacityMult = 2;
+  oboe::PerformanceMode _performanceMode = oboe::PerformanceMode::LowLatency;
   bool _fullDuplex;
+  int _inChannels = oboe::ChannelCount::Mono;
+  int _outChannels = oboe::ChannelCount::Mono;
   float *silentInBuff = nullptr;
-  std::atomic<float> _slider0;
-  std::atomic<float> _slider1;
-  std::atomic<float> _slider2;
-  std::atomic<float> _slider3;
-  float _sliders[4] = {0};
-  bool _slidersOff;
 
-  std::function<void()> _updateCtrlInBufferCallback;
+  bool _latencyTuning = false;
+  std::atomic<int> _tunerState{tuner_off};
+  std::atomic<bool> _tunerShouldStop{false};
+  bool _tunerRunning = false;
+  pthread_t tuner_thread;
+  void* tuner_func();
+  static void* tuner_func_static(void* arg);
+  void stopLatencyTuner();
 
   oboe::Result createStream(bool isInput);
+  int alignToBurst(int frames, int burstSize);
 };
 
 
 //----------------------------------
 
-inline void OboeAudioEngine::callRender(int audioFrames, float* audioIn, float* audioOut) {
-  intContext.audioFrames = audioFrames;
-  intContext.audioIn = audioIn;
-  intContext.audioOut = audioOut;
-
-  if(!_slidersOff)
-  {
-    intContext.sliders[0] = _slider0.load();
-    intContext.sliders[1] = _slider2.load();
-    intContext.sliders[2] = _slider2.load();
-    intContext.sliders[3] = _slider3.load();
-  }
-
-  if (_updateCtrlInBufferCallback) {
-    _updateCtrlInBufferCallback();
-  }
-  
-  render(userContext, nullptr);
-}
-
 inline float OboeAudioEngine::getSampleRate() {
   return (float) getOutputStream()->getSampleRate();
 }
@@ -125,20 +103,12 @@ inline int OboeAudioEngine::getFullDuplex() {
   return _fullDuplex;
 }
 
-inline void OboeAudioEngine::setSlider0(float param) {
-  _slider0.store(param);
-}
-
-inline void OboeAudioEngine::setSlider1(float param) {
-  _slider1.store(param);
-}
-
-inline void OboeAudioEngine::setSlider2(float param) {
-  _slider2.store(param);
+inline int OboeAudioEngine::getInChannels() {
+  return intContext.audioInChannels;
 }
 
-inline void OboeAudioEngine::setSlider3(float param){
-  _slider3.store(param);
+inline int OboeAudioEngine::getOutChannels() {
+  return intContext.audioOutChannels;
 }
 
 }  // namespace ldsplite
\ No newline at end of file
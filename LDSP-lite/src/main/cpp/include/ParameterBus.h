@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ldsplite {
+
+// Carries parameter changes [GUI sliders, JNI, websockets...] to the audio thread without locks
+// any number of threads can set() at any time, while the audio thread calls update() once per render()
+// each set() stores the new target and flags the parameter in a dirty bitmask, so update() costs one atomic exchange every 64 parameters
+// plus work proportional to the parameters that actually changed or are still ramping, not to how many parameters there are
+// if a parameter is set several times between two updates, only the last value counts
+class ParameterBus {
+ public:
+  explicit ParameterBus(int capacity);
+
+  int getCapacity() const { return _capacity; }
+
+  // any thread; return false if index is out of range
+  bool set(int index, float value);
+  // new values are reached linearly within rampMs, 0 [default] jumps right away
+  // it applies from the next set() on
+  bool setSmoothing(int index, float rampMs);
+
+  // audio thread only
+  // moves ramps forward by audioFrames and brings in new values; results are in getValues()
+  void update(int audioFrames, float sampleRate);
+  // the current, smoothed value of each parameter, meant to be shared with render() via the context
+  float *getValues() { return _values.get(); }
+
+ private:
+  static constexpr int bitsPerWord = 64;
+
+  int _capacity;
+  int _words;
+
+  // written by set()
+  std::unique_ptr<std::atomic<float>[]> _targets;
+  std::unique_ptr<std::atomic<float>[]> _rampMs;
+  std::unique_ptr<std::atomic<uint64_t>[]> _dirty;
+
+  // audio thread state
+  std::unique_ptr<float[]> _values;
+  std::unique_ptr<float[]> _rampTargets;
+  std::unique_ptr<float[]> _rampSteps; // per frame
+  std::unique_ptr<int[]> _rampFramesLeft;
+  std::unique_ptr<int[]> _ramping; // indices of the parameters that are ramping, the first _numRamping are valid
+  std::unique_ptr<int[]> _rampSlot; // where each parameter is in _ramping, -1 if not ramping
+  int _numRamping = 0;
+
+  void startRamp(int index, float target, float sampleRate);
+  void stopRamp(int index);
+};
+
+}  // namespace ldsplite
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "thread_utils.h"
+#include <atomic>
+#include <cstdint>
+
+namespace ldsplite {
+
+// snapshot of render() timing, as returned by RenderTimer::getStats()
+// loads are render() time as a fraction of the buffer period, i.e., 1 means render() took the whole period
+struct RenderTimingStats {
+  static constexpr int histogramBins = 21; // 20 bins of 5% of the period each, the last one collects everything >= 100%
+  static constexpr float binWidth = 0.05;
+
+  uint64_t callbacks;
+  float meanLoad;
+  float worstLoad;
+  uint32_t overruns; // callbacks in which render() took longer than the period
+  int32_t xruns; // as reported by the driver, -1 if not available
+  uint32_t histogram[histogramBins];
+};
+
+// Times each call to render() with monotonic_ns() and keeps a histogram of the load
+// there is a single writer, the audio thread, while any other thread can poll getStats() without locking
+// when disabled, the audio thread only pays for one relaxed atomic load per callback
+class RenderTimer {
+ public:
+  RenderTimer();
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+  // audio thread only, startNs from monotonic_ns()
+  void record(int64_t startNs, int audioFrames, float sampleRate);
+
+  // any thread
+  // counters are read one by one, so they may be off by one callback with respect to each other
+  void getStats(RenderTimingStats &stats) const;
+  // actual reset is carried out by the audio thread at the next recorded callback
+  void reset();
+
+ private:
+  std::atomic<bool> _enabled{false};
+  std::atomic<bool> _resetRequested{false};
+
+  std::atomic<uint64_t> _callbacks{0};
+  std::atomic<double> _totalLoad{0};
+  std::atomic<float> _worstLoad{0};
+  std::atomic<uint32_t> _overruns{0};
+  std::atomic<uint32_t> _histogram[RenderTimingStats::histogramBins];
+
+  void clear();
+};
+
+
+//----------------------------------
+
+// single writer, so plain loads and stores are enough, no need for read-modify-write atomics
+inline void RenderTimer::record(int64_t startNs, int audioFrames, float sampleRate) {
+  int64_t endNs = monotonic_ns();
+
+  if(_resetRequested.load(std::memory_order_relaxed)) {
+    clear();
+    _resetRequested.store(false, std::memory_order_relaxed);
+  }
+
+  // period can change from callback to callback, so it is computed each time
+  float load = (endNs - startNs) * sampleRate / (audioFrames * 1000000000.0f);
+
+  int bin = (int)(load / RenderTimingStats::binWidth);
+  if(bin >= RenderTimingStats::histogramBins)
+    bin = RenderTimingStats::histogramBins - 1;
+  _histogram[bin].store(_histogram[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  if(load > _worstLoad.load(std::memory_order_relaxed))
+    _worstLoad.store(load, std::memory_order_relaxed);
+  if(load >= 1)
+    _overruns.store(_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  _totalLoad.store(_totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+  _callbacks.store(_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}  // namespace ldsplite
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ldsplite {
+
+// Bounded single producer single consumer queue of fixed-size items, no locks and no allocations
+// each side owns one index and only reads the other's, which is kept on its own cache line so that they do not bounce
+// if the ring is full, push() fails and the item is counted as an overflow
+template<typename T, uint32_t Capacity>
+class SpscRing {
+  static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of 2");
+
+ public:
+  // producer only
+  bool push(const T &item) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if(head - _tail.load(std::memory_order_acquire) == Capacity) {
+      _overflows.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _items[head & mask] = item;
+    // release, so that the consumer sees the item once it sees the new head
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer only
+  bool pop(T &item) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if(tail == _head.load(std::memory_order_acquire))
+      return false;
+    item = _items[tail & mask];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer only, drops everything that is queued
+  void clear() {
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  uint32_t getOverflows() const { return _overflows.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr uint32_t mask = Capacity - 1;
+
+  alignas(64) std::atomic<uint32_t> _head{0}; // next slot to write
+  alignas(64) std::atomic<uint32_t> _tail{0}; // next slot to read
+  alignas(64) std::atomic<uint32_t> _overflows{0};
+  T _items[Capacity];
+};
+
+}  // namespace ldsplite
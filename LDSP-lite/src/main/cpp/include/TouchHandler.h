@@ -7,37 +7,52 @@
 
 #include "LDSP.h"
 #include <atomic>
-#include <array>
+#include <mutex>
 
 namespace ldsplite {
 
 struct TouchData {
-  std::atomic<int> id{-1};
-  std::atomic<float> x{0};
-  std::atomic<float> y{0};
-  std::atomic<float> pressure{0};
-  std::atomic<float> majAxis{0};
-  std::atomic<float> minAxis{0};
-  std::atomic<float> orientation{0};
-  std::atomic<float> hoverX{0};
-  std::atomic<float> hoverY{0};
-  std::atomic<float> majWidth{0};
-  std::atomic<float> minWidth{0};
+  int id = -1;
+  float x = 0;
+  float y = 0;
+  float pressure = 0;
+  float majAxis = 0;
+  float minAxis = 0;
+  float orientation = 0;
+  float hoverX = 0;
+  float hoverY = 0;
+  float majWidth = 0;
+  float minWidth = 0;
 };
 
+// Touch updates come from the UI thread and are handed to the audio thread through a triple buffer:
+// the writer always has a back buffer of its own to copy the updated frame into, then swaps it with the middle one,
+// while the reader swaps the middle one with its front buffer only if something new was published
+// the audio thread pays one atomic load per callback when nothing changed, and one exchange plus the int conversion when something did
 class TouchHandler {
  public:
   static constexpr int MAX_SLOTS = 10;
+  // batched updates are arrays of records of this many floats:
+  // slot, id, x, y, pressure, majAxis, minAxis, orientation, majWidth, minWidth
+  // an id of -1 clears the slot
+  static constexpr int BATCH_RECORD_SIZE = 10;
+  // anyTouch value that leaves anyTouch as it is
+  static constexpr int ANY_TOUCH_UNCHANGED = -1;
+
+  // complete multitouch state, published as a whole so that the audio thread never sees half an update [e.g., new x with old y]
+  struct TouchFrame {
+    int anyTouch = 0;
+    TouchData touches[MAX_SLOTS];
+  };
 
   TouchHandler() {
-    anyTouch.store(0);
-    for (int i = 0; i < MAX_SLOTS; ++i) {
-      _touches[i].id.store(-1, std::memory_order_relaxed);
-    }
+    _middle.store(1, std::memory_order_relaxed); // front is 0, back is 2
   }
 
   void updateAnyTouch(int state) {
-    anyTouch.store(state);
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    _working.anyTouch = state;
+    publish();
   }
 
   void updateTouch(int slot, int id, float x, float y, float pressure,
@@ -45,26 +60,61 @@ class TouchHandler {
                    float majWidth, float minWidth) {
     if (slot < 0 || slot >= MAX_SLOTS) return;
 
-    _touches[slot].id.store(id, std::memory_order_relaxed);
-    _touches[slot].x.store(x, std::memory_order_relaxed);
-    _touches[slot].y.store(y, std::memory_order_relaxed);
-    _touches[slot].pressure.store(pressure, std::memory_order_relaxed);
-    _touches[slot].majAxis.store(majAxis, std::memory_order_relaxed);
-    _touches[slot].minAxis.store(minAxis, std::memory_order_relaxed);
-    _touches[slot].orientation.store(orientation, std::memory_order_relaxed);
-    _touches[slot].majWidth.store(majWidth, std::memory_order_relaxed);
-    _touches[slot].minWidth.store(minWidth, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    TouchData &touch = _working.touches[slot];
+    touch.id = id;
+    touch.x = x;
+    touch.y = y;
+    touch.pressure = pressure;
+    touch.majAxis = majAxis;
+    touch.minAxis = minAxis;
+    touch.orientation = orientation;
+    touch.majWidth = majWidth;
+    touch.minWidth = minWidth;
+    publish();
+  }
+
+  // all pointers of a motion event at once, the audio thread sees them all or none
+  void updateBatch(const float* records, int count, int anyTouch) {
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    if (anyTouch != ANY_TOUCH_UNCHANGED)
+      _working.anyTouch = anyTouch;
+
+    for (int r = 0; r < count; ++r) {
+      const float* record = records + r * BATCH_RECORD_SIZE;
+      int slot = static_cast<int>(record[0]);
+      if (slot < 0 || slot >= MAX_SLOTS) continue;
+
+      TouchData &touch = _working.touches[slot];
+      touch.id = static_cast<int>(record[1]);
+      if (touch.id == -1) continue;
+      touch.x = record[2];
+      touch.y = record[3];
+      touch.pressure = record[4];
+      touch.majAxis = record[5];
+      touch.minAxis = record[6];
+      touch.orientation = record[7];
+      touch.majWidth = record[8];
+      touch.minWidth = record[9];
+    }
+    publish();
   }
 
   void updateHover(int slot, float hoverX, float hoverY) {
     if (slot < 0 || slot >= MAX_SLOTS) return;
-    _touches[slot].hoverX.store(hoverX, std::memory_order_relaxed);
-    _touches[slot].hoverY.store(hoverY, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    _working.touches[slot].hoverX = hoverX;
+    _working.touches[slot].hoverY = hoverY;
+    publish();
   }
 
   void clearTouch(int slot) {
     if (slot < 0 || slot >= MAX_SLOTS) return;
-    _touches[slot].id.store(-1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    _working.touches[slot].id = -1;
+    publish();
   }
 
   void setScreenResolution(float width, float height) {
@@ -72,81 +122,95 @@ class TouchHandler {
     _screenHeight = height;
   }
 
+  // audio thread only
+  // grabs the latest published frame, if any; returns true if it changed since the previous call
+  bool acquireSnapshot() {
+    if ((_middle.load(std::memory_order_relaxed) & kFresh) == 0)
+      return false;
+    // acquire, to see the whole frame the writer copied in before publishing it
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  // audio thread only, valid until the next acquireSnapshot()
+  const TouchFrame &getSnapshot() const {
+    return _buffers[_front];
+  }
+
   // Populate ctrlInputs array with touch data
+  // only does the work if a new frame was published, ctrlInputs keeps the previous values otherwise
   void populateCtrlInputs(int* ctrlInputs, int touchSlots) {
-    // Skip button section (chn_btn_count elements)
-    int offset = chn_btn_count;
-
-    // Set anyTouch flag - check if any touch is active
-//    int anyTouch = 0;
-//    for (const auto& touch : _touches) {
-//      if (touch.id.load(std::memory_order_relaxed) != -1) {
-//        anyTouch = 1;
-//        break;
-//      }
-//    }
-    ctrlInputs[offset] = anyTouch.load();//anyTouch;
-    offset++;
+    populate(ctrlInputs, touchSlots, 1000.0f, _populated);
+  }
 
-    // Fill touch data for each channel
-    // Layout: (channel-1) * touchSlots + slot
-    int slots = (touchSlots < MAX_SLOTS) ? touchSlots : MAX_SLOTS;
+  // same for the float version of ctrlInputs, no truncation and pressure stays in 0-1
+  void populateCtrlInputsF(float* ctrlInputs, int touchSlots) {
+    populate(ctrlInputs, touchSlots, 1.0f, _populatedF);
+  }
 
-    for (int slot = 0; slot < slots; ++slot) {
-      // chn_mt_x (channel index 0 after anyTouch)
-      ctrlInputs[offset + 0 * slots + slot] =
-          static_cast<int>(_touches[slot].x.load(std::memory_order_relaxed));
+  float getScreenWidth() const { return _screenWidth; }
+  float getScreenHeight() const { return _screenHeight; }
 
-      // chn_mt_y (channel index 1)
-      ctrlInputs[offset + 1 * slots + slot] =
-          static_cast<int>(_touches[slot].y.load(std::memory_order_relaxed));
+ private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4; // set in _middle when it holds a frame the reader has not seen yet
 
-      // chn_mt_majAxis (channel index 2)
-      ctrlInputs[offset + 2 * slots + slot] =
-          static_cast<int>(_touches[slot].majAxis.load(std::memory_order_relaxed));
+  // writer side, touch events may come from more than one thread
+  std::mutex _writeMutex;
+  TouchFrame _working;
+  int _back = 2;
 
-      // chn_mt_minAxis (channel index 3)
-      ctrlInputs[offset + 3 * slots + slot] =
-          static_cast<int>(_touches[slot].minAxis.load(std::memory_order_relaxed));
+  TouchFrame _buffers[3];
+  std::atomic<int> _middle;
 
-      // chn_mt_orientation (channel index 4)
-      ctrlInputs[offset + 4 * slots + slot] =
-          static_cast<int>(_touches[slot].orientation.load(std::memory_order_relaxed));
+  // reader side
+  int _front = 0;
+  bool _populated = false;
+  bool _populatedF = false;
 
-      // chn_mt_hoverX (channel index 5)
-      ctrlInputs[offset + 5 * slots + slot] =
-          static_cast<int>(_touches[slot].hoverX.load(std::memory_order_relaxed));
+  float _screenWidth = 1920.0f;
+  float _screenHeight = 1080.0f;
 
-      // chn_mt_hoverY (channel index 6)
-      ctrlInputs[offset + 6 * slots + slot] =
-          static_cast<int>(_touches[slot].hoverY.load(std::memory_order_relaxed));
+  // T is int or float
+  template<typename T>
+  void populate(T* ctrlInputs, int touchSlots, float pressureScale, bool &populated) {
+    if (!acquireSnapshot() && populated)
+      return;
+    populated = true;
 
-      // chn_mt_majWidth (channel index 7)
-      ctrlInputs[offset + 7 * slots + slot] =
-          static_cast<int>(_touches[slot].majWidth.load(std::memory_order_relaxed));
+    const TouchFrame &frame = getSnapshot();
 
-      // chn_mt_minWidth (channel index 8)
-      ctrlInputs[offset + 8 * slots + slot] =
-          static_cast<int>(_touches[slot].minWidth.load(std::memory_order_relaxed));
+    // Skip button section (chn_btn_count elements)
+    int offset = chn_btn_count;
+    ctrlInputs[offset] = static_cast<T>(frame.anyTouch);
+    offset++;
 
-      // chn_mt_pressure (channel index 9)
-      ctrlInputs[offset + 9 * slots + slot] =
-          static_cast<int>(_touches[slot].pressure.load(std::memory_order_relaxed) * 1000.0f);
+    // Fill touch data for each channel
+    // Layout: (channel-1) * touchSlots + slot
+    int slots = (touchSlots < MAX_SLOTS) ? touchSlots : MAX_SLOTS;
 
-      // chn_mt_id (channel index 10)
-      ctrlInputs[offset + 10 * slots + slot] =
-          _touches[slot].id.load(std::memory_order_relaxed);
+    for (int slot = 0; slot < slots; ++slot) {
+      const TouchData &touch = frame.touches[slot];
+      ctrlInputs[offset + 0 * slots + slot] = static_cast<T>(touch.x);
+      ctrlInputs[offset + 1 * slots + slot] = static_cast<T>(touch.y);
+      ctrlInputs[offset + 2 * slots + slot] = static_cast<T>(touch.majAxis);
+      ctrlInputs[offset + 3 * slots + slot] = static_cast<T>(touch.minAxis);
+      ctrlInputs[offset + 4 * slots + slot] = static_cast<T>(touch.orientation);
+      ctrlInputs[offset + 5 * slots + slot] = static_cast<T>(touch.hoverX);
+      ctrlInputs[offset + 6 * slots + slot] = static_cast<T>(touch.hoverY);
+      ctrlInputs[offset + 7 * slots + slot] = static_cast<T>(touch.majWidth);
+      ctrlInputs[offset + 8 * slots + slot] = static_cast<T>(touch.minWidth);
+      ctrlInputs[offset + 9 * slots + slot] = static_cast<T>(touch.pressure * pressureScale);
+      ctrlInputs[offset + 10 * slots + slot] = static_cast<T>(touch.id);
     }
   }
 
-  float getScreenWidth() const { return _screenWidth; }
-  float getScreenHeight() const { return _screenHeight; }
-
- private:
-  std::atomic<int> anyTouch;
-  std::array<TouchData, MAX_SLOTS> _touches;
-  float _screenWidth = 1920.0f;
-  float _screenHeight = 1080.0f;
+  // writer only, with _writeMutex held
+  void publish() {
+    _buffers[_back] = _working;
+    // release, so that the reader sees the whole frame once it gets this buffer
+    _back = _middle.exchange(_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+  }
 };
 
 } // namespace ldsplite
@@ -25,7 +25,10 @@ The Bela software is distributed under the GNU Lesser General Public License (LG
 #include <string>
 #include <memory>
 #include <map>
+#include <atomic>
 #include "thread_utils.h"
+#include "MpscByteRing.h"
+#include "SpscRing.h"
 
 // forward declarations for faster render.cpp compiles
 namespace seasocks{
@@ -34,12 +37,34 @@ namespace seasocks{
 //class AuxTaskNonRT;
 struct GuiWSHandler;
 
-constexpr unsigned int WSOutDataMax = 200;
+constexpr unsigned int WSOutDataMax = 200; // longer messages do not go in the output queue, but in a slab
+constexpr unsigned int WSSlabCount = 16;
+constexpr unsigned int WSSlabSize = 16384; // largest message, e.g., 4096 floats
 
+// what precedes the data of each message in the output queue
+// short messages follow it in the queue, long ones are in a slab [the record tag is the slab index + 1] and only their size is here
+// an optional header message comes first, e.g., the id of the buffer that follows, so that the two always travel together
 struct WSOutputData {
-	char* address;
-	char buff[WSOutDataMax];
-    unsigned int size;
+	const char* address;
+	unsigned int slabSize;
+	unsigned int headerSize; // 0 if no header
+};
+
+// the client thread moves messages from the output queue into batches, that are sent by the server thread with a single execute()
+// batches are preallocated and recycled, so sending does not allocate
+struct WSMessage {
+	GuiWSHandler* handler;
+	const char* data; // in the batch, or in a slab
+	unsigned int size;
+	int slab; // -1 if the data are in the batch
+};
+struct WSBatch {
+	static constexpr unsigned int maxMessages = 256;
+	static constexpr unsigned int maxBytes = 16384;
+	WSMessage messages[maxMessages];
+	unsigned int numMessages = 0;
+	char data[maxBytes]; // short messages, null-terminated
+	unsigned int numBytes = 0;
 };
 
 class WSServer{
@@ -52,24 +77,75 @@ class WSServer{
 
 		void addAddress(std::string address, std::function<void(std::string, void*, int)> on_receive = nullptr, std::function<void(std::string)> on_connect = nullptr, std::function<void(std::string)> on_disconnect = nullptr, bool binary = false);
 		
+		// these are lock-free and can be called from any thread at the same time, e.g., the audio thread sending data
+		// while the seasocks thread replies to a GUI connection; they never block
+		// return 0 on success, -1 if the message was dropped because the output queue is full [i.e., the caller is sending too fast]
+		// address must stay valid until the message is sent, e.g., a string owned by the caller
 		int send(const char* address, const char* str);
 		int send(const char* address, const void* buf, unsigned int size);
-		
+		// header [up to WSOutDataMax chars] and data go out as two consecutive messages, either both or neither
+		int send(const char* address, const char* header, const void* buf, unsigned int size);
+
+		// zero-copy version for long messages, e.g., full audio blocks or spectra
+		// acquireSlab() returns memory for up to WSSlabSize bytes [nullptr if all slabs are in flight], the caller fills it in place
+		// and hands it over with sendSlab(), which always takes ownership; releaseSlab() gives it back unsent
+		// the slab returns to the pool once the message has gone out to all the connections
+		void* acquireSlab();
+		int sendSlab(const char* address, void* slab, unsigned int size);
+		void releaseSlab(void* slab);
+
+		// back-pressure, for callers that want to slow down before messages get dropped
+		unsigned int getOutputQueueSpace() const { return outputs.getFreeSpace(); }
+		unsigned int getDroppedCount() const { return outputs.getOverflows(); }
+
 	protected:
 		void cleanup();
 
-		static constexpr int output_queue_size = 100; // this is the number of outputs that can be written in a row without the risk of skipping transmission
+		static constexpr unsigned int output_queue_bytes = 65536; // messages and their headers, several blocks worth of GUI traffic
 
 		unsigned int _port;	
 		std::shared_ptr<seasocks::Server> server;
 		std::map< std::string, std::shared_ptr<GuiWSHandler> > address_book;
 		
-	    bool shouldStop;
+	    std::atomic<bool> shouldStop{false};
 
 		pthread_t client_thread;
-		std::atomic<WSOutputData> outputs[output_queue_size];
-    	int outputs_readPtr;
-    	std::atomic<int> outputs_writePtr;
+		ldsplite::MpscByteRing outputs{output_queue_bytes}; // written by send() from any thread, read by the client thread
+		std::atomic<unsigned int> truncatedCount{0}; // reported by the client thread, send() must not print
+		// slabs for long messages, taken by the sender and freed by the server thread once sent
+		// each one has an extra byte, to null-terminate text messages in place
+		std::unique_ptr<char[]> slabs{new char[WSSlabCount*(WSSlabSize+1)]};
+		std::atomic<bool> slabInUse[WSSlabCount] = {};
+		std::atomic<unsigned int> slabNext{0}; // where senders start looking for a free slab, just a hint
+		char* getSlab(unsigned int index) { return slabs.get() + index*(WSSlabSize+1); }
+		// the client thread sleeps on this eventfd, send() signals it only if it is not already pending,
+		// so a burst of messages [e.g., all the sends of a block] costs a single wakeup
+		int clientWakeFd = -1;
+		std::atomic<bool> clientWakePending{false};
+		void wakeClient();
+		void initClient();
+		// the record for a message whose data are already in a slab, takes ownership of it
+		int queueSlab(const char* address, const char* header, unsigned int headerSize, void* slab, unsigned int size);
+
+		static constexpr unsigned int batch_count = 4;
+		std::unique_ptr<WSBatch[]> batches{new WSBatch[batch_count]};
+		ldsplite::SpscRing<WSBatch*, batch_count> freeBatches; // returned by the server thread, taken by the client thread
+		WSBatch* spareBatch = nullptr; // client thread only, a batch that could not be handed to the server thread
+		WSBatch* takeBatch();
+		void addToBatch(WSBatch* batch, GuiWSHandler* handler, const void* data, unsigned int size, int slab);
+		void flushBatch(WSBatch* batch);
+		void sendBatch(WSBatch* batch);
+		void clearBatch(WSBatch* batch);
+
+		// client thread only, so that the address does not have to be looked up in address_book for each message
+		static constexpr unsigned int handler_cache_size = 16;
+		struct {
+			const char* address;
+			GuiWSHandler* handler;
+		} handlerCache[handler_cache_size];
+		unsigned int handlerCacheCount = 0;
+		GuiWSHandler* getHandler(const char* address);
+
 		void* client_func();
 		static void* client_func_static(void* arg);
 
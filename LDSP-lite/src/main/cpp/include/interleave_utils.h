@@ -0,0 +1,17 @@
+/*
+ * interleave_utils.h
+ *
+ * conversions between the interleaved buffers the audio drivers use
+ * and the planar [one contiguous array per channel] view render() can opt in to
+ * mono is a plain copy, stereo uses NEON or SSE when available, any other channel count falls back to scalar loops
+ */
+
+#ifndef INTERLEAVE_UTILS_H_
+#define INTERLEAVE_UTILS_H_
+
+// in holds frames*channels interleaved samples, out holds one array of at least frames samples per channel
+void deinterleave(const float *in, float * const *out, int frames, int channels);
+// inverse of deinterleave()
+void interleave(const float * const *in, float *out, int frames, int channels);
+
+#endif /* INTERLEAVE_UTILS_H_ */
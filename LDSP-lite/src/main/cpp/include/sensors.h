@@ -7,39 +7,97 @@
 
 #include <android/sensor.h>
 #include <unordered_map> // unordered_map
+#include <atomic>
+#include <functional>
 #include "LDSP.h"
-#include "OboeAudioEngine.h" // for LDSPinternalContext
-#include "enums.h"
+#include "AudioEngine.h" // for LDSPinternalContext
+#include "SpscRing.h"
 
 using std::unordered_map;
 
-// wrapper of android sensor types, to ensure compatibility with older and newer versions of Android
+// sensors we support, in the same order as their channels in the sensorChannel enum in LDSP.h
 // note that we include only a subset of all the sensors supported by android, because many of them are not very 'useful'
-// this is a special wrapper, that permits to print the ENUM ad to cycle via indices
-ENUM(LDSP_sensor, short,
-     accelerometer = ASENSOR_TYPE_ACCELEROMETER,
-     magnetometer  = ASENSOR_TYPE_MAGNETIC_FIELD,
-     gyroscope     = ASENSOR_TYPE_GYROSCOPE,
-     light         = ASENSOR_TYPE_LIGHT,
-     proximity     = ASENSOR_TYPE_PROXIMITY,
-     count         = 5 // BE CAREFUL! this entry has to be updated manually and it does not matter if has same value as other entries
-// minimum set of sensors, compatible all the way down to Android 4.1 Jelly Bean, API level 16
-//TODO extend this according to API LEVEL
-)
-// number of input channels associated with each sensor
-// BE CAREFUL! this has to be updated manually, according to:
-// LDSP_sensor ENUMs [same number of entries, sam order]
-// AND
-// sensorChannel enum in LDSP.h [each LDSP_sensor entry has to correspond to 1 or mulitple sensorChannel enum entry, according to number of channels set in here]
-static const string sensors_channelsInfo[LDSP_sensor::count][2] = {
-    {"3", "acceleration on x [m/s^2], acceleration on y [m/s^2], acceleration on z [m/s^2]"}, // accelerometer
-    {"3", "magentic field on x [uT], magentic field on y [uT], magentic field on z [uT]"}, // magnetometer
-    {"3", "rate of rotation around x [rad/s], rate of rotation around y [rad/s], rate of rotation around z [rad/s]"}, // gyroscope
-    {"1", "illuminance [lx]"}, // light
-    {"1", "distance [cm]"}  // proximity
+// X(name, android sensor type, first channel, channel descriptions...)
+// this list is the only thing to edit to add a sensor [plus its channels in LDSP.h], the number of channels is the number of descriptions
+// and the enum, the info table and the consistency checks below are all generated from it at compile time
+#define LDSP_SENSORS_BASE(X) \
+  X(accelerometer, ASENSOR_TYPE_ACCELEROMETER, chn_sens_accelX, \
+    "acceleration on x [m/s^2]", "acceleration on y [m/s^2]", "acceleration on z [m/s^2]") \
+  X(magnetometer, ASENSOR_TYPE_MAGNETIC_FIELD, chn_sens_magX, \
+    "magentic field on x [uT]", "magentic field on y [uT]", "magentic field on z [uT]") \
+  X(gyroscope, ASENSOR_TYPE_GYROSCOPE, chn_sens_gyroX, \
+    "rate of rotation around x [rad/s]", "rate of rotation around y [rad/s]", "rate of rotation around z [rad/s]") \
+  X(light, ASENSOR_TYPE_LIGHT, chn_sens_light, \
+    "illuminance [lx]") \
+  X(proximity, ASENSOR_TYPE_PROXIMITY, chn_sens_proximity, \
+    "distance [cm]")
+// minimum set of sensors above, compatible all the way down to Android 4.1 Jelly Bean, API level 16
+
+// fused and environmental sensors, the game rotation vector [and the scalar component of the rotation vector] need API level 18
+// if the build targets an older API, their channels stay 'Not supported', like those of sensors missing on the phone
+#if __ANDROID_API__ >= 18
+#define LDSP_SENSORS_EXTENDED(X) \
+  X(rotationVector, ASENSOR_TYPE_ROTATION_VECTOR, chn_sens_rotVecX, \
+    "rotation vector x*sin(theta/2)", "rotation vector y*sin(theta/2)", "rotation vector z*sin(theta/2)", "rotation vector cos(theta/2)") \
+  X(gameRotationVector, ASENSOR_TYPE_GAME_ROTATION_VECTOR, chn_sens_gameRotVecX, \
+    "game rotation vector x*sin(theta/2)", "game rotation vector y*sin(theta/2)", "game rotation vector z*sin(theta/2)", "game rotation vector cos(theta/2)") \
+  X(linearAcceleration, ASENSOR_TYPE_LINEAR_ACCELERATION, chn_sens_linAccelX, \
+    "linear acceleration on x [m/s^2]", "linear acceleration on y [m/s^2]", "linear acceleration on z [m/s^2]") \
+  X(gravity, ASENSOR_TYPE_GRAVITY, chn_sens_gravityX, \
+    "gravity on x [m/s^2]", "gravity on y [m/s^2]", "gravity on z [m/s^2]") \
+  X(pressure, ASENSOR_TYPE_PRESSURE, chn_sens_pressure, \
+    "atmospheric pressure [hPa]")
+#else
+#define LDSP_SENSORS_EXTENDED(X)
+#endif
+
+#define LDSP_SENSORS(X) LDSP_SENSORS_BASE(X) LDSP_SENSORS_EXTENDED(X)
+
+// max number of channels of any sensor, checked below
+constexpr int sensors_maxChannels = 4;
+
+// LDSP_sensor::accelerometer... are indices into sensors_info and LDSPsensorsContext::sensors
+struct LDSP_sensor {
+  enum _enum : short {
+#define LDSP_SENSOR_ENUM(name, type, firstChannel, ...) name,
+    LDSP_SENSORS(LDSP_SENSOR_ENUM)
+#undef LDSP_SENSOR_ENUM
+    count
+  };
+};
+
+struct sensor_info {
+  const char *name;
+  int type; // ASENSOR_TYPE_*
+  sensorChannel firstChannel; // channels are contiguous
+  unsigned int numOfChannels;
+  const char *channelsDetails[sensors_maxChannels];
+};
+
+template<typename... Details>
+constexpr unsigned int sensors_countChannels(Details...) { return sizeof...(Details); }
+
+constexpr sensor_info sensors_info[LDSP_sensor::count] = {
+#define LDSP_SENSOR_INFO(name, type, firstChannel, ...) \
+  {#name, type, firstChannel, sensors_countChannels(__VA_ARGS__), {__VA_ARGS__}},
+    LDSP_SENSORS(LDSP_SENSOR_INFO)
+#undef LDSP_SENSOR_INFO
 };
 //VIC any ways to retrieve number of channels per sensor from freaking android API?!?!?
 
+// each sensor's channels must start right after the previous sensor's, with no gaps, and fit in sensorChannel
+constexpr bool sensors_channelsConsistent() {
+  int next = 0;
+  for(int i=0; i<LDSP_sensor::count; i++) {
+    if(sensors_info[i].firstChannel != next || sensors_info[i].numOfChannels > sensors_maxChannels)
+      return false;
+    next += sensors_info[i].numOfChannels;
+  }
+  return next <= chn_sens_count;
+}
+static_assert(sensors_channelsConsistent(), "LDSP_SENSORS does not match the sensorChannel enum in LDSP.h");
+static_assert(LDSP_sensor::count <= LDSP_sensorsMax, "LDSP_sensorsMax in LDSP.h is too small for all the sensors");
+
 // if max values are reported in here, the sensor input is normalized
 // BE CAREFUL! this has to updated manually, according to LDSP_sensor ENUMs
 // static const float sensors_max[LDSP_sensor::count] = {
@@ -50,13 +108,26 @@ static const string sensors_channelsInfo[LDSP_sensor::count][2] = {
 //     10
 // };
 
-
 struct sensor_struct {
   const ASensor *asensor;
   bool present;
   unsigned int type;
   unsigned int numOfChannels;
   sensorChannel *channels;
+  int minDelay; // us, 0 if the sensor reports only when data change
+  int64_t timestamp; // ns, of the latest sample that made it into the sensor buffer
+  float requestedRate; // Hz, what we asked for, after clamping to minDelay; 0 if the sensor reports on change
+  std::atomic<float> effectiveRate{0}; // Hz, measured on the event timestamps, updated about once per second
+  // sensor thread only, to measure effectiveRate
+  int64_t rateWindowStart;
+  int rateWindowEvents;
+};
+
+// one sensor event, on its way from the sensor thread to the audio thread
+struct sensor_sample {
+  int64_t timestamp; // ns, as reported by Android
+  int sensorIndex; // in LDSPsensorsContext::sensors
+  float data[sensors_maxChannels];
 };
 
 struct LDSPsensorsContext {
@@ -68,6 +139,14 @@ struct LDSPsensorsContext {
   string *sensorsDetails;
 };
 
+// sensor thread, moves all pending events from the sensor queue into the ring
 void readSensors();
+// audio thread, applies the samples in the ring to the sensor buffer, no syscalls
+void updateSensors();
+// called on the sensor thread for each sample as soon as it is read, with its time on the monotonic_ns() clock
+// to be set before LDSP_initSensors()
+void setSensorEventCallback(std::function<void(int64_t timeNs, const sensor_sample &sample)> callback);
+// effective rate [Hz] of each LDSP_sensor, 0 for sensors that are not present or have not reported yet; returns how many were written
+int getSensorRates(float *rates, int count);
 
 #endif //LDSP_LITE_LDSP_LITE_SRC_MAIN_CPP_INCLUDE_SENSORS_H_
@@ -28,6 +28,8 @@
 #define PRIORITY_UTILS_H_
 
 #include <pthread.h>
+#include <chrono>
+#include <cstdint>
 
 // main threads ordered by priority [order 0 is max priority]
 constexpr unsigned int LDSPprioOrder_audio = 0;
@@ -58,6 +60,13 @@ constexpr unsigned int LDSPprioOrder_wserverClient = 20;
 void set_priority(int order, bool verbose); // 0 is max prio, cos at front end we do not know what's the highest prio
 void set_niceness(int niceness, bool verbose); // -20 is highest prio niceness, it's a known standard
 
+//-----------------------------------------------------------------------------------------------------------
+// monotonic time in ns, the one clock shared by render() timing, control event stamps and sensor timestamps
+//-----------------------------------------------------------------------------------------------------------
+inline int64_t monotonic_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 
 
 #endif /* PRIORITY_UTILS_H_ */
@@ -22,6 +22,7 @@ The Bela software is distributed under the GNU Lesser General Public License (LG
 #include "AudioFile.h"
 #include <unistd.h> //for sync
 #include <cstdlib>
+#include <cstring> // memcpy
 #include <iostream>
 #include "files_utils.h"
 #include "LDSP_log.h"
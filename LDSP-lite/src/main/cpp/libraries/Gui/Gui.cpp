@@ -365,10 +365,10 @@ int Gui::sendControl(nlohmann::json root) {
 int Gui::doSendBuffer(const char* type, unsigned int bufferId, const void* data, size_t size)
 {
 	std::string idTypeStr = std::to_string(bufferId) + "/" + std::string(type);
+	// one record, so that the header can never go out without its data
 	int ret;
-	if(0 == (ret = web_server->send(_addressData.c_str(), idTypeStr.c_str())))
-                    if(0 == (ret = web_server->send(_addressData.c_str(), (void*)data, size)))
-                            return 0;
+	if(0 == (ret = web_server->send(_addressData.c_str(), idTypeStr.c_str(), data, size)))
+		return 0;
 	fprintf(stderr, "You are sending messages to the GUI too fast. Please slow down\n");
 	return ret;
 }
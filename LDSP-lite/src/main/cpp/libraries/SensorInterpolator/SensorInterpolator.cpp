@@ -0,0 +1,231 @@
+#include "SensorInterpolator.h"
+#include "LDSP_log.h"
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INTERPOLATOR_NEON
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define INTERPOLATOR_SSE
+#endif
+
+// out[n] = start + n*increment
+static void fillRamp(float *out, float start, float increment, int frames) {
+	int n = 0;
+#if defined(INTERPOLATOR_NEON)
+	float32x4_t vStart = vdupq_n_f32(start);
+	float32x4_t vInc = vdupq_n_f32(increment);
+	float32x4_t vIdx = {0, 1, 2, 3};
+	float32x4_t vFour = vdupq_n_f32(4);
+	for(; n+4<=frames; n+=4) {
+		// from the index each time, rather than accumulating, so that rounding errors do not add up
+		vst1q_f32(out + n, vmlaq_f32(vStart, vIdx, vInc));
+		vIdx = vaddq_f32(vIdx, vFour);
+	}
+#elif defined(INTERPOLATOR_SSE)
+	__m128 vStart = _mm_set1_ps(start);
+	__m128 vInc = _mm_set1_ps(increment);
+	__m128 vIdx = _mm_setr_ps(0, 1, 2, 3);
+	__m128 vFour = _mm_set1_ps(4);
+	for(; n+4<=frames; n+=4) {
+		_mm_storeu_ps(out + n, _mm_add_ps(vStart, _mm_mul_ps(vIdx, vInc)));
+		vIdx = _mm_add_ps(vIdx, vFour);
+	}
+#endif
+	// leftovers, or everything if no SIMD
+	for(; n<frames; n++)
+		out[n] = start + n*increment;
+}
+
+// out[n] = target + distance*coeff^n, i.e., the one-pole recursion in closed form, 4 frames at a time
+static void fillGlide(float *out, float target, float distance, float coeff, int frames) {
+	int n = 0;
+	float coeff2 = coeff*coeff;
+#if defined(INTERPOLATOR_NEON)
+	float32x4_t vTarget = vdupq_n_f32(target);
+	float32x4_t vDist = {distance, distance*coeff, distance*coeff2, distance*coeff2*coeff};
+	float32x4_t vCoeff4 = vdupq_n_f32(coeff2*coeff2);
+	for(; n+4<=frames; n+=4) {
+		vst1q_f32(out + n, vaddq_f32(vTarget, vDist));
+		vDist = vmulq_f32(vDist, vCoeff4);
+	}
+	distance = vgetq_lane_f32(vDist, 0);
+#elif defined(INTERPOLATOR_SSE)
+	__m128 vTarget = _mm_set1_ps(target);
+	__m128 vDist = _mm_setr_ps(distance, distance*coeff, distance*coeff2, distance*coeff2*coeff);
+	__m128 vCoeff4 = _mm_set1_ps(coeff2*coeff2);
+	for(; n+4<=frames; n+=4) {
+		_mm_storeu_ps(out + n, _mm_add_ps(vTarget, vDist));
+		vDist = _mm_mul_ps(vDist, vCoeff4);
+	}
+	distance = _mm_cvtss_f32(vDist);
+#endif
+	for(; n<frames; n++) {
+		out[n] = target + distance;
+		distance *= coeff;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+
+void SensorInterpolator::setup(LDSPcontext *context, unsigned int maxFrames)
+{
+	maxFrames_ = (maxFrames > 0) ? maxFrames : context->audioFramesMax;
+	sampleRate_ = context->audioSampleRate;
+	coeffFrames_ = 0; // recomputed at the first process()
+	framesValid_ = true;
+	warnedTooLong_ = false;
+
+	channels_.clear();
+	channels_.resize(context->sensorChannels);
+}
+
+void SensorInterpolator::setChannel(int channel, Interpolation type, float smoothingMs, float lowpassHz, int medianLength, bool perFrame)
+{
+	if(channel < 0 || channel >= (int)channels_.size())
+		return;
+
+	Channel &chn = channels_[channel];
+	chn.enabled = true;
+	chn.type = type;
+	chn.perFrame = perFrame;
+	chn.smoothingMs = (smoothingMs > 0) ? smoothingMs : 0;
+	chn.lowpassHz = (lowpassHz > 0) ? lowpassHz : 0;
+	if(medianLength > maxMedianLength)
+		medianLength = maxMedianLength;
+	chn.medianLength = (medianLength > 1) ? (medianLength | 1) : 0; // odd, so that there is a middle value
+	chn.historyPos = 0;
+	chn.historyCount = 0;
+	chn.primed = false;
+
+	// allocated here, never in process()
+	chn.frames.assign(perFrame ? maxFrames_ : 0, 0);
+
+	// the per-frame pole does not depend on the block size
+	if(chn.type == onePole && chn.smoothingMs > 0)
+		chn.poleCoeff = expf(-1000.0f / (chn.smoothingMs * sampleRate_));
+	else
+		chn.poleCoeff = 0;
+
+	if(coeffFrames_ > 0)
+		updateCoefficients(chn, coeffFrames_);
+}
+
+void SensorInterpolator::disableChannel(int channel)
+{
+	if(channel < 0 || channel >= (int)channels_.size())
+		return;
+	channels_[channel].enabled = false;
+	channels_[channel].frames.clear();
+}
+
+void SensorInterpolator::process(LDSPcontext *context)
+{
+	unsigned int frames = context->audioFrames;
+	if(frames == 0)
+		return;
+
+	// per-frame buffers cannot grow here, so a longer block falls back to the ramp rather than handing out a short buffer
+	framesValid_ = (frames <= maxFrames_);
+	if(!framesValid_ && !warnedTooLong_) {
+		LDSP_log("SensorInterpolator: block of %u frames is longer than maxFrames %u, getFrames() is not available", frames, maxFrames_);
+		warnedTooLong_ = true;
+	}
+
+	// block size changes are rare [never with a fixed render block size], coefficients are computed only then
+	if(frames != coeffFrames_) {
+		coeffFrames_ = frames;
+		for(Channel &chn : channels_) {
+			if(chn.enabled)
+				updateCoefficients(chn, frames);
+		}
+	}
+
+	int numChannels = channels_.size();
+	for(int c=0; c<numChannels; c++) {
+		Channel &chn = channels_[c];
+		if(!chn.enabled)
+			continue;
+
+		float in = context->sensors[c];
+		if(chn.medianLength > 1)
+			in = median(chn, in);
+
+		if(!chn.primed) {
+			// nothing to glide from, start flat on the first value
+			chn.value = in;
+			chn.end = in;
+			chn.primed = true;
+		}
+		else if(chn.lowpassHz > 0)
+			chn.value += chn.lowpassCoeff * (in - chn.value);
+		else
+			chn.value = in;
+
+		chn.start = chn.end;
+		if(chn.type == onePole) {
+			float distance = chn.start - chn.value;
+			chn.end = chn.value + distance*chn.poleCoeffBlock;
+			chn.increment = (chn.end - chn.start) / frames;
+			if(chn.perFrame && framesValid_)
+				fillGlide(chn.frames.data(), chn.value, distance, chn.poleCoeff, frames);
+		}
+		else {
+			chn.end = chn.value;
+			chn.increment = (chn.end - chn.start) / frames;
+			if(chn.perFrame && framesValid_)
+				fillRamp(chn.frames.data(), chn.start, chn.increment, frames);
+		}
+	}
+}
+
+float SensorInterpolator::read(int channel, int frame)
+{
+	Channel &chn = channels_[channel];
+	if(chn.perFrame && framesValid_)
+		return chn.frames[frame];
+	if(chn.type == onePole)
+		return chn.value + (chn.start - chn.value)*powf(chn.poleCoeff, frame);
+	return chn.start + frame*chn.increment;
+}
+
+void SensorInterpolator::getRamp(int channel, float &start, float &increment)
+{
+	start = channels_[channel].start;
+	increment = channels_[channel].increment;
+}
+
+//-----------------------------------------------------------------------------------------------
+
+float SensorInterpolator::median(Channel &chn, float in)
+{
+	chn.history[chn.historyPos] = in;
+	chn.historyPos = (chn.historyPos + 1) % chn.medianLength;
+	if(chn.historyCount < chn.medianLength)
+		chn.historyCount++;
+
+	// at most maxMedianLength values, insertion sort is as good as anything
+	float sorted[maxMedianLength];
+	int count = chn.historyCount;
+	for(int i=0; i<count; i++) {
+		float v = chn.history[i];
+		int j = i;
+		for(; j>0 && sorted[j-1]>v; j--)
+			sorted[j] = sorted[j-1];
+		sorted[j] = v;
+	}
+	return sorted[count/2];
+}
+
+void SensorInterpolator::updateCoefficients(Channel &chn, unsigned int frames)
+{
+	// the low-pass runs once per block
+	float blockRate = sampleRate_ / frames;
+	if(chn.lowpassHz > 0)
+		chn.lowpassCoeff = 1.0f - expf(-2.0f * (float)M_PI * chn.lowpassHz / blockRate);
+	else
+		chn.lowpassCoeff = 1;
+
+	chn.poleCoeffBlock = powf(chn.poleCoeff, frames);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "LDSP.h"
+#include <vector>
+
+// Turns the stepwise, block-rate sensor values in context->sensors into smooth, audio-rate control signals
+// each sensor channel goes through up to three stages, all configured once in setup():
+// - median filter over the latest block-rate values, to get rid of spikes [e.g., proximity glitches]
+// - one-pole low-pass at block rate, to tame jitter [e.g., accelerometer noise]
+// - upsampling to audio rate, either as a linear ramp from the previous value, or as a one-pole glide towards the new one
+// channels that are not configured are not processed
+//
+// usage:
+//   setup():  interp.setup(context);
+//             interp.setChannel(chn_sens_accelX, SensorInterpolator::linear);
+//   render(): interp.process(context);
+//             float *x = interp.getFrames(chn_sens_accelX); // one value per frame [nullptr if the block is longer than maxFrames]
+//          or float start, inc; interp.getRamp(chn_sens_accelX, start, inc); // start + n*inc
+class SensorInterpolator {
+public:
+	typedef enum {
+		linear,  // reaches the new value at the end of the block, one block of extra delay but no overshoot or zipper noise
+		onePole, // glides towards the new value from the beginning of the block, with time constant smoothingMs
+		numInterpolationTypes
+	} Interpolation;
+
+	SensorInterpolator(){};
+	SensorInterpolator(LDSPcontext *context, unsigned int maxFrames = 0)
+	{
+		setup(context, maxFrames);
+	}
+	~SensorInterpolator(){};
+
+	// maxFrames is the largest block process() will see, 0 is context->audioFramesMax
+	void setup(LDSPcontext *context, unsigned int maxFrames = 0);
+
+	// medianLength 0 or 1 is no median, otherwise odd, up to maxMedianLength
+	// lowpassHz 0 is no low-pass, and must be lower than the block rate [samplerate/audioFrames] to do anything
+	// smoothingMs is the time constant of the onePole interpolation, not used by linear
+	// perFrame false skips filling the getFrames() buffer, for channels read only via getRamp() or getValue()
+	void setChannel(int channel, Interpolation type, float smoothingMs = 10, float lowpassHz = 0, int medianLength = 0, bool perFrame = true);
+	void disableChannel(int channel);
+
+	// once per render(), before reading any channel
+	void process(LDSPcontext *context);
+
+	// audioFrames values, valid until the next process()
+	// nullptr if the block was longer than maxFrames, then only read() and getRamp() work
+	const float *getFrames(int channel) { return framesValid_ ? channels_[channel].frames.data() : nullptr; }
+	// value at the given frame, same as getFrames()[frame] but also works for channels with perFrame false
+	float read(int channel, int frame);
+	// the block as a ramp: value at frame n is start + n*increment; exact for linear, a straight-line approximation for onePole
+	void getRamp(int channel, float &start, float &increment);
+	// filtered, block-rate value, before upsampling
+	float getValue(int channel) { return channels_[channel].value; }
+
+	static constexpr int maxMedianLength = 9; // odd
+
+private:
+	struct Channel {
+		bool enabled = false;
+		Interpolation type = linear;
+		bool perFrame = true;
+		float smoothingMs = 10;
+		float lowpassHz = 0;
+		int medianLength = 0;
+
+		float history[maxMedianLength]; // latest raw values, circular
+		int historyPos = 0;
+		int historyCount = 0;
+		float value = 0; // after median and low-pass
+		bool primed = false; // the first value is taken as is, with no glide from 0
+
+		float start = 0; // value at frame 0 of the current block
+		float end = 0; // value right after the last frame of the current block
+		float increment = 0;
+		float poleCoeff = 0; // onePole only, per frame
+		float poleCoeffBlock = 0; // onePole only, poleCoeff^audioFrames
+		float lowpassCoeff = 0; // per block
+		std::vector<float> frames;
+	};
+
+	std::vector<Channel> channels_;
+	unsigned int maxFrames_ = 0;
+	float sampleRate_ = 44100;
+	unsigned int coeffFrames_ = 0; // block size the per-block coefficients were computed for
+	bool framesValid_ = true; // false if the current block did not fit in the per-frame buffers
+	bool warnedTooLong_ = false;
+
+	float median(Channel &chn, float in);
+	void updateCoefficients(Channel &chn, unsigned int frames);
+};
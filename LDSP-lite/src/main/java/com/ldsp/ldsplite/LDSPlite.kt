@@ -6,8 +6,41 @@ interface LDSPlite {
   suspend fun start()
   suspend fun stop()
   suspend fun isPlaying() : Boolean
-  suspend fun setSlider0(value: Float)
-  suspend fun setSlider1(value: Float)
-  suspend fun setSlider2(value: Float)
-  suspend fun setSlider3(value: Float)
+  // any parameter read in render() via sliderRead(), setSliderN() are shortcuts for the first four
+  suspend fun setParameter(index: Int, value: Float)
+  // changes to the parameter are ramped linearly within rampMs, 0 to jump
+  suspend fun setParameterSmoothing(index: Int, rampMs: Float)
+  suspend fun setSlider0(value: Float) = setParameter(0, value)
+  suspend fun setSlider1(value: Float) = setParameter(1, value)
+  suspend fun setSlider2(value: Float) = setParameter(2, value)
+  suspend fun setSlider3(value: Float) = setParameter(3, value)
+  // takes effect at the next start(), periodSize is rounded to the device's burst size and samplerate 0 means native
+  // performanceMode: 0 none, 1 power saving, 2 low latency
+  suspend fun setAudioSettings(periodSize: Int, samplerate: Float, bufferCapacityMult: Int, performanceMode: Int)
+  // takes effect at the next start(), counts must be between 1 and 8, returns false and keeps the previous ones otherwise
+  suspend fun setChannelCounts(inChannels: Int, outChannels: Int): Boolean
+  // takes effect at the next start(), render() then always gets blocks of this size at the cost of one block of latency
+  // 0 follows the callbacks
+  suspend fun setRenderBlockSize(frames: Int)
+  // frames, 0 if no render block size is set
+  suspend fun getRenderBlockLatency(): Int
+  // takes effect at the next start()
+  suspend fun setLatencyTuning(enabled: Boolean)
+  // 0 off, 1 tuning, 2 done, 3 unsupported
+  suspend fun getLatencyTunerState(): Int
+  suspend fun getOutputBufferSize(): Int
+  // takes effect at the next start(), resamples the input to follow the output clock
+  suspend fun setDriftCompensation(enabled: Boolean)
+  // [ratio, fillLevel, targetFillLevel, underflows, overflows]
+  suspend fun getDriftStats(): DoubleArray
+  // takes effect at the next start(), sensor is the index in LDSP_sensor [accelerometer, magnetometer, gyroscope, light, proximity,
+  // rotationVector, gameRotationVector, linearAcceleration, gravity, pressure]
+  // rateHz 0 gives one sample per audio block, -1 the fastest rate the sensor supports
+  suspend fun setSensorRate(sensor: Int, rateHz: Float)
+  // effective rate of each sensor while running, 0 if not present
+  suspend fun getSensorRates(): DoubleArray
+  suspend fun setRenderTimingEnabled(enabled: Boolean)
+  suspend fun resetRenderTiming()
+  // [callbacks, meanLoad, worstLoad, overruns, xruns, histogram bins of 5% of the period...]
+  suspend fun getRenderTimingStats(): DoubleArray
 }
@@ -6,6 +6,7 @@ import android.content.pm.ActivityInfo
 import android.content.pm.PackageManager
 import android.graphics.Color
 import android.os.Bundle
+import android.view.KeyEvent
 import androidx.activity.ComponentActivity
 import androidx.activity.compose.setContent
 import androidx.compose.ui.viewinterop.AndroidView
@@ -117,6 +118,25 @@ class MainActivity : ComponentActivity() {
     super.onResume()
     ldspViewModel.applySliders()
   }
+
+  // hardware buttons go to the project as control inputs, before any view can consume them
+  // they are not consumed here, so volume keys still change the volume, like in LDSP
+  // the power key is handled by the system and never makes it to apps
+  override fun dispatchKeyEvent(event: KeyEvent): Boolean {
+    val channel = when (event.keyCode) {
+      KeyEvent.KEYCODE_POWER -> NativeLDSPlite.BUTTON_POWER
+      KeyEvent.KEYCODE_VOLUME_UP -> NativeLDSPlite.BUTTON_VOL_UP
+      KeyEvent.KEYCODE_VOLUME_DOWN -> NativeLDSPlite.BUTTON_VOL_DOWN
+      else -> -1
+    }
+    if (channel >= 0 && event.repeatCount == 0) {
+      when (event.action) {
+        KeyEvent.ACTION_DOWN -> nativeLDSP.updateButton(channel, true)
+        KeyEvent.ACTION_UP -> nativeLDSP.updateButton(channel, false)
+      }
+    }
+    return super.dispatchKeyEvent(event)
+  }
 }
 
 @Composable
@@ -3,6 +3,7 @@ package com.ldsp.ldsplite
 import android.content.Context
 import androidx.lifecycle.DefaultLifecycleObserver
 import androidx.lifecycle.LifecycleOwner
+import java.nio.ByteBuffer
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 
@@ -15,10 +16,22 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
   private external fun start(ldspLiteHandle: Long)
   private external fun stop(ldspLiteHanlde: Long)
   private external fun isPlaying(ldspLiteHanlde: Long): Boolean
-  private external fun setSlider0(ldspLiteHanlde: Long, value: Float)
-  private external fun setSlider1(ldspLiteHanlde: Long, value: Float)
-  private external fun setSlider2(ldspLiteHanlde: Long, value: Float)
-  private external fun setSlider3(ldspLiteHanlde: Long, value: Float)
+  private external fun setParameter(ldspLiteHanlde: Long, index: Int, value: Float)
+  private external fun setParameterSmoothing(ldspLiteHanlde: Long, index: Int, rampMs: Float)
+  private external fun setAudioSettings(ldspLiteHanlde: Long, periodSize: Int, samplerate: Float, bufferCapacityMult: Int, performanceMode: Int)
+  private external fun setChannelCounts(ldspLiteHanlde: Long, inChannels: Int, outChannels: Int): Boolean
+  private external fun setRenderBlockSize(ldspLiteHanlde: Long, frames: Int)
+  private external fun getRenderBlockLatency(ldspLiteHanlde: Long): Int
+  private external fun setLatencyTuning(ldspLiteHanlde: Long, enabled: Boolean)
+  private external fun getLatencyTunerState(ldspLiteHanlde: Long): Int
+  private external fun getOutputBufferSize(ldspLiteHanlde: Long): Int
+  private external fun setDriftCompensation(ldspLiteHanlde: Long, enabled: Boolean)
+  private external fun getDriftStats(ldspLiteHanlde: Long): DoubleArray
+  private external fun setSensorRate(ldspLiteHanlde: Long, sensor: Int, rateHz: Float)
+  private external fun getSensorRates(ldspLiteHanlde: Long): DoubleArray
+  private external fun setRenderTimingEnabled(ldspLiteHanlde: Long, enabled: Boolean)
+  private external fun resetRenderTiming(ldspLiteHanlde: Long)
+  private external fun getRenderTimingStats(ldspLiteHanlde: Long): DoubleArray
 
   private external fun storeInstanceInNative(instance: NativeLDSPlite)
   private external fun storeContextInNative(context: Context)
@@ -41,9 +54,13 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
     minWidth: Float
   )
 
+  // buffer must be direct and in native byte order, see TouchSurfaceView for the record layout
+  external fun updateTouchBatch(ldspLiteHanlde: Long, buffer: ByteBuffer, count: Int, anyTouch: Int)
   external fun updateHover(ldspLiteHanlde: Long, slot: Int, hoverX: Float, hoverY: Float)
   external fun clearTouch(ldspLiteHanlde: Long, slot: Int)
   external fun setScreenResolution(ldspLiteHanlde: Long, width: Float, height: Float)
+  // channel is one of the BUTTON_ constants
+  external fun updateButton(ldspLiteHanlde: Long, channel: Int, pressed: Boolean)
   init {
     // Store the instance in the native code when this object is created
     storeInstanceInNative(this)
@@ -55,6 +72,11 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
     init {
       System.loadLibrary("ldsplite")
     }
+
+    // same order as btnInputChannel in LDSP.h
+    const val BUTTON_POWER = 0
+    const val BUTTON_VOL_UP = 1
+    const val BUTTON_VOL_DOWN = 2
   }
 
   override fun onResume(owner: LifecycleOwner) {
@@ -119,31 +141,115 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
     }
   }
 
-  override suspend fun setSlider0(value: Float) = withContext(Dispatchers.Default) {
+  override suspend fun setParameter(index: Int, value: Float) = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      setParameter(ldspLiteHandle, index, value)
+    }
+  }
+
+  override suspend fun setParameterSmoothing(index: Int, rampMs: Float) = withContext(Dispatchers.Default) {
     synchronized(ldspLiteMutex) {
       createNativeHandleIfNotExists()
-      setSlider0(ldspLiteHandle, value)
+      setParameterSmoothing(ldspLiteHandle, index, rampMs)
     }
   }
 
-  override suspend fun setSlider1(value: Float) = withContext(Dispatchers.Default) {
+  override suspend fun setAudioSettings(periodSize: Int, samplerate: Float, bufferCapacityMult: Int, performanceMode: Int) = withContext(Dispatchers.Default) {
     synchronized(ldspLiteMutex) {
       createNativeHandleIfNotExists()
-      setSlider1(ldspLiteHandle, value)
+      setAudioSettings(ldspLiteHandle, periodSize, samplerate, bufferCapacityMult, performanceMode)
     }
   }
 
-  override suspend fun setSlider2(value: Float) = withContext(Dispatchers.Default) {
+  override suspend fun setChannelCounts(inChannels: Int, outChannels: Int) = withContext(Dispatchers.Default) {
     synchronized(ldspLiteMutex) {
       createNativeHandleIfNotExists()
-      setSlider2(ldspLiteHandle, value)
+      setChannelCounts(ldspLiteHandle, inChannels, outChannels)
     }
   }
 
-  override suspend fun setSlider3(value: Float) = withContext(Dispatchers.Default) {
+  override suspend fun setRenderBlockSize(frames: Int) = withContext(Dispatchers.Default) {
     synchronized(ldspLiteMutex) {
       createNativeHandleIfNotExists()
-      setSlider3(ldspLiteHandle, value)
+      setRenderBlockSize(ldspLiteHandle, frames)
+    }
+  }
+
+  override suspend fun getRenderBlockLatency(): Int = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getRenderBlockLatency(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun setLatencyTuning(enabled: Boolean) = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      setLatencyTuning(ldspLiteHandle, enabled)
+    }
+  }
+
+  override suspend fun getLatencyTunerState(): Int = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getLatencyTunerState(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun getOutputBufferSize(): Int = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getOutputBufferSize(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun setDriftCompensation(enabled: Boolean) = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      setDriftCompensation(ldspLiteHandle, enabled)
+    }
+  }
+
+  override suspend fun getDriftStats(): DoubleArray = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getDriftStats(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun setSensorRate(sensor: Int, rateHz: Float) = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      setSensorRate(ldspLiteHandle, sensor, rateHz)
+    }
+  }
+
+  override suspend fun getSensorRates(): DoubleArray = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getSensorRates(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun setRenderTimingEnabled(enabled: Boolean) = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      setRenderTimingEnabled(ldspLiteHandle, enabled)
+    }
+  }
+
+  override suspend fun resetRenderTiming() = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      resetRenderTiming(ldspLiteHandle)
+    }
+  }
+
+  override suspend fun getRenderTimingStats(): DoubleArray = withContext(Dispatchers.Default) {
+    synchronized(ldspLiteMutex) {
+      createNativeHandleIfNotExists()
+      return@withContext getRenderTimingStats(ldspLiteHandle)
     }
   }
 
@@ -183,6 +289,14 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
     }
   }
 
+  fun updateTouchBatch(buffer: ByteBuffer, count: Int, anyTouch: Int) {
+    synchronized(ldspLiteMutex) {
+      if (ldspLiteHandle != 0L) {
+        updateTouchBatch(ldspLiteHandle, buffer, count, anyTouch)
+      }
+    }
+  }
+
   fun updateHover(slot: Int, hoverX: Float, hoverY: Float) {
     synchronized(ldspLiteMutex) {
       if (ldspLiteHandle != 0L) {
@@ -206,4 +320,12 @@ class NativeLDSPlite(context: Context) : LDSPlite, DefaultLifecycleObserver {
       }
     }
   }
+
+  fun updateButton(channel: Int, pressed: Boolean) {
+    synchronized(ldspLiteMutex) {
+      if (ldspLiteHandle != 0L) {
+        updateButton(ldspLiteHandle, channel, pressed)
+      }
+    }
+  }
 }
@@ -6,6 +6,9 @@ import android.util.Log
 import android.view.InputDevice
 import android.view.MotionEvent
 import android.view.View
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
 
 class TouchSurfaceView @JvmOverloads constructor(
   context: Context,
@@ -19,22 +22,41 @@ class TouchSurfaceView @JvmOverloads constructor(
     nativeLDSP = native
   }
 
+  // all the pointers of a motion event go to native in one call, as records of RECORD_FLOATS floats:
+  // slot, id, x, y, pressure, majAxis, minAxis, orientation, majWidth, minWidth [id -1 clears the slot]
+  // must match TouchHandler::BATCH_RECORD_SIZE
+  private val batchBuffer: ByteBuffer = ByteBuffer.allocateDirect(MAX_RECORDS * RECORD_FLOATS * 4).order(ByteOrder.nativeOrder())
+  private val batch: FloatBuffer = batchBuffer.asFloatBuffer()
+  private var batchCount = 0
+
+  // which optional axes the current device reports, checked once per event rather than per pointer
+  private var hasTouchMajor = false
+  private var hasTouchMinor = false
+  private var hasOrientation = false
+  private var hasToolMajor = false
+  private var hasToolMinor = false
+
   override fun onTouchEvent(event: MotionEvent): Boolean {
     if (nativeLDSP == null) return false
 
     val pointerCount = event.pointerCount
     val action = event.actionMasked
     val actionIndex = event.actionIndex
+    var anyTouch = ANY_TOUCH_UNCHANGED
+
+    batch.clear()
+    batchCount = 0
+    checkAxes(event)
 
     when (action) {
       MotionEvent.ACTION_DOWN -> {
         // First finger down - anyTouch becomes true
-        nativeLDSP?.updateAnyTouch(1)
+        anyTouch = 1
 
         val pointerId = event.getPointerId(actionIndex)
         val slot = findSlotForId(pointerId)
         if (slot >= 0) {
-          updateTouchData(event, actionIndex, slot, pointerId)
+          addTouchData(event, actionIndex, slot, pointerId)
         }
       }
 
@@ -43,7 +65,7 @@ class TouchSurfaceView @JvmOverloads constructor(
         val pointerId = event.getPointerId(actionIndex)
         val slot = findSlotForId(pointerId)
         if (slot >= 0) {
-          updateTouchData(event, actionIndex, slot, pointerId)
+          addTouchData(event, actionIndex, slot, pointerId)
         }
       }
 
@@ -53,7 +75,7 @@ class TouchSurfaceView @JvmOverloads constructor(
           val pointerId = event.getPointerId(i)
           val slot = findSlotForId(pointerId)
           if (slot >= 0) {
-            updateTouchData(event, i, slot, pointerId)
+            addTouchData(event, i, slot, pointerId)
           }
         }
       }
@@ -63,19 +85,19 @@ class TouchSurfaceView @JvmOverloads constructor(
         val pointerId = event.getPointerId(actionIndex)
         val slot = findSlotForId(pointerId)
         if (slot >= 0) {
-          nativeLDSP?.clearTouch(slot)
+          addClear(slot)
           releaseSlot(slot)
         }
       }
 
       MotionEvent.ACTION_UP -> {
         // Last finger up - anyTouch becomes false
-        nativeLDSP?.updateAnyTouch(0)
+        anyTouch = 0
 
         val pointerId = event.getPointerId(actionIndex)
         val slot = findSlotForId(pointerId)
         if (slot >= 0) {
-          nativeLDSP?.clearTouch(slot)
+          addClear(slot)
           releaseSlot(slot)
         }
       }
@@ -90,11 +112,11 @@ class TouchSurfaceView @JvmOverloads constructor(
 
       MotionEvent.ACTION_CANCEL -> {
         // System cancelled all touches - anyTouch becomes false
-        nativeLDSP?.updateAnyTouch(0)
-        
+        anyTouch = 0
+
         // Clear all slots that we think are active, not just what's in the event
         for ((pointerId, slot) in slotMap.entries) {
-          nativeLDSP?.clearTouch(slot)
+          addClear(slot)
         }
         // Now reset our tracking
         usedSlots.fill(false)
@@ -102,47 +124,53 @@ class TouchSurfaceView @JvmOverloads constructor(
       }
     }
 
+    if (batchCount > 0 || anyTouch != ANY_TOUCH_UNCHANGED) {
+      nativeLDSP?.updateTouchBatch(batchBuffer, batchCount, anyTouch)
+    }
+
     return true
   }
 
+  private fun checkAxes(event: MotionEvent) {
+    val ranges = event.device?.motionRanges
+    hasTouchMajor = ranges?.any { it.axis == MotionEvent.AXIS_TOUCH_MAJOR } ?: false
+    hasTouchMinor = ranges?.any { it.axis == MotionEvent.AXIS_TOUCH_MINOR } ?: false
+    hasOrientation = ranges?.any { it.axis == MotionEvent.AXIS_ORIENTATION } ?: false
+    hasToolMajor = ranges?.any { it.axis == MotionEvent.AXIS_TOOL_MAJOR } ?: false
+    hasToolMinor = ranges?.any { it.axis == MotionEvent.AXIS_TOOL_MINOR } ?: false
+  }
 
-  private fun updateTouchData(event: MotionEvent, pointerIndex: Int, slot: Int, pointerId: Int) {
-    val x = event.getX(pointerIndex)
-    val y = event.getY(pointerIndex)
-    val pressure = event.getPressure(pointerIndex)
-
-    // Get axis values if available
-    val majAxis = if (event.device.motionRanges.any { it.axis == MotionEvent.AXIS_TOUCH_MAJOR }) {
-      event.getTouchMajor(pointerIndex)
-    } else 0f
-
-    val minAxis = if (event.device.motionRanges.any { it.axis == MotionEvent.AXIS_TOUCH_MINOR }) {
-      event.getTouchMinor(pointerIndex)
-    } else 0f
-
-    val orientation = if (event.device.motionRanges.any { it.axis == MotionEvent.AXIS_ORIENTATION }) {
-      event.getOrientation(pointerIndex)
-    } else 0f
-
-    val majWidth = if (event.device.motionRanges.any { it.axis == MotionEvent.AXIS_TOOL_MAJOR }) {
-      event.getToolMajor(pointerIndex)
-    } else 0f
+  private fun addTouchData(event: MotionEvent, pointerIndex: Int, slot: Int, pointerId: Int) {
+    if (batchCount >= MAX_RECORDS) return
+
+    batch.put(slot.toFloat())
+    batch.put(pointerId.toFloat())
+    batch.put(event.getX(pointerIndex))
+    batch.put(event.getY(pointerIndex))
+    batch.put(event.getPressure(pointerIndex))
+    // axis values, if available
+    batch.put(if (hasTouchMajor) event.getTouchMajor(pointerIndex) else 0f)
+    batch.put(if (hasTouchMinor) event.getTouchMinor(pointerIndex) else 0f)
+    batch.put(if (hasOrientation) event.getOrientation(pointerIndex) else 0f)
+    batch.put(if (hasToolMajor) event.getToolMajor(pointerIndex) else 0f)
+    batch.put(if (hasToolMinor) event.getToolMinor(pointerIndex) else 0f)
+    batchCount++
+  }
 
-    val minWidth = if (event.device.motionRanges.any { it.axis == MotionEvent.AXIS_TOOL_MINOR }) {
-      event.getToolMinor(pointerIndex)
-    } else 0f
+  private fun addClear(slot: Int) {
+    if (batchCount >= MAX_RECORDS) return
 
-    // Send to native
-    nativeLDSP?.updateTouch(
-      slot, pointerId, x, y, pressure,
-      majAxis, minAxis, orientation,
-      majWidth, minWidth
-    )
+    batch.put(slot.toFloat())
+    batch.put(-1f)
+    for (i in 2 until RECORD_FLOATS) {
+      batch.put(0f)
+    }
+    batchCount++
   }
 
   // Simple slot management - maps pointer IDs to slots
   private val slotMap = mutableMapOf<Int, Int>()
-  private val usedSlots = BooleanArray(10) // Support up to 10 touches
+  private val usedSlots = BooleanArray(MAX_SLOTS) // Support up to 10 touches
 
   private fun findSlotForId(pointerId: Int): Int {
     // Check if we already have a slot for this ID
@@ -179,4 +207,12 @@ class TouchSurfaceView @JvmOverloads constructor(
     // Update screen resolution in native code
     nativeLDSP?.setScreenResolution(w.toFloat(), h.toFloat())
   }
+
+  companion object {
+    private const val MAX_SLOTS = 10
+    private const val RECORD_FLOATS = 10
+    // an update or a clear per slot, plus all clears on cancel
+    private const val MAX_RECORDS = 2 * MAX_SLOTS
+    private const val ANY_TOUCH_UNCHANGED = -1
+  }
 }
\ No newline at end of file